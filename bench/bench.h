@@ -0,0 +1,23 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+// Runs `fn` repeatedly for about `seconds` and returns calls per second.
+// One untimed call first warms caches and any lazy dispatch.
+template <typename Fn>
+double calls_per_second(Fn &&fn, double seconds = 0.5) {
+  fn();
+  const auto start = std::chrono::steady_clock::now();
+  const auto budget = std::chrono::duration<double>(seconds);
+  size_t calls = 0;
+  std::chrono::duration<double> elapsed{};
+  do {
+    for (int i = 0; i < 16; ++i) {
+      fn();
+    }
+    calls += 16;
+    elapsed = std::chrono::steady_clock::now() - start;
+  } while (elapsed < budget);
+  return static_cast<double>(calls) / elapsed.count();
+}
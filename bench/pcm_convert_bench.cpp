@@ -0,0 +1,39 @@
+// Float to PCM16 conversion and PCM16 mixing: the dispatched kernel against
+// the scalar reference, on capture-sized blocks.
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "pcm_convert.h"
+
+int main() {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> audio(-1.0f, 1.0f);
+  std::printf("kernel: %s\n", pcm_convert_kernel_name());
+  std::printf("%-8s %-10s %12s %12s %8s\n", "block", "operation", "scalar", "dispatched", "speedup");
+  for (const size_t block : {480, 4096}) {
+    std::vector<float> in(block);
+    for (float &x : in) {
+      x = audio(rng);
+    }
+    std::vector<short> a(block);
+    std::vector<short> b(block);
+    std::vector<short> out(block);
+    float_to_pcm16_scalar(in.data(), a.data(), block);
+    float_to_pcm16_scalar(in.data() + block / 2, b.data(), block - block / 2);
+
+    const double samples = static_cast<double>(block);
+    const double convert_scalar = calls_per_second([&] { float_to_pcm16_scalar(in.data(), out.data(), block); });
+    const double convert = calls_per_second([&] { float_to_pcm16(in.data(), out.data(), block); });
+    const double mix_scalar =
+        calls_per_second([&] { mix_pcm16_scalar(a.data(), 0.8f, b.data(), 0.6f, out.data(), block); });
+    const double mix = calls_per_second([&] { mix_pcm16(a.data(), 0.8f, b.data(), 0.6f, out.data(), block); });
+    std::printf("%-8zu %-10s %9.0f M/s %9.0f M/s %7.1fx\n", block, "convert", convert_scalar * samples / 1e6,
+                convert * samples / 1e6, convert / convert_scalar);
+    std::printf("%-8zu %-10s %9.0f M/s %9.0f M/s %7.1fx\n", block, "mix", mix_scalar * samples / 1e6,
+                mix * samples / 1e6, mix / mix_scalar);
+  }
+  return 0;
+}
@@ -0,0 +1,49 @@
+// Resampler throughput per quality tier and rate pair, in capture-sized
+// packets, as a multiple of realtime.
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "bench.h"
+#include "resampler.h"
+
+int main() {
+  const struct {
+    size_t in_rate;
+    size_t out_rate;
+  } cases[] = {{48000, 16000}, {44100, 16000}, {96000, 16000}, {22050, 16000}};
+  const struct {
+    const char *name;
+    Resampler::Quality quality;
+  } tiers[] = {{"fast", Resampler::Quality::Fast},
+               {"balanced", Resampler::Quality::Balanced},
+               {"high", Resampler::Quality::High}};
+
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> audio(-1.0f, 1.0f);
+  std::printf("%-16s %-9s %6s %12s %12s\n", "rates", "quality", "taps", "in M/s", "x realtime");
+  for (const auto &c : cases) {
+    // 10 ms packets, as a typical capture period delivers.
+    std::vector<float> packet(c.in_rate / 100);
+    for (float &x : packet) {
+      x = audio(rng);
+    }
+    for (const auto &tier : tiers) {
+      Resampler resampler;
+      if (!resampler.configure(c.in_rate, c.out_rate, tier.quality)) {
+        continue;
+      }
+      resampler.reserve(packet.size());
+      std::vector<float> out;
+      out.reserve(packet.size());
+      const double packets = calls_per_second([&] { resampler.process(packet, out); });
+      const double samples = packets * static_cast<double>(packet.size());
+      char rates[32];
+      std::snprintf(rates, sizeof(rates), "%zu -> %zu", c.in_rate, c.out_rate);
+      std::printf("%-16s %-9s %6zu %12.1f %12.0f\n", rates, tier.name, resampler.taps(), samples / 1e6,
+                  samples / static_cast<double>(c.in_rate));
+    }
+  }
+  return 0;
+}
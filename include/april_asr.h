@@ -1,35 +1,198 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <filesystem>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <queue>
+#include <span>
 #include <string>
 #include <vector>
 
 #include "april_api.h"
+#include "april_model.h"
 
 class AprilAsrEngine {
 public:
+  enum class Mode {
+    // Feed audio as it is captured; decoding runs on april-asr's thread and
+    // trades accuracy for keeping up.
+    AsyncRealtime,
+    // Same thread, full accuracy; falls behind if the CPU cannot keep up.
+    AsyncNoRealtime,
+    // Decoding runs inside push_*() on the caller's thread. For files.
+    Synchronous,
+  };
+
+  // A final result and where it lies in the audio fed to the session.
+  struct TimedText {
+    std::string text;
+    size_t start_ms = 0;
+    size_t end_ms = 0;
+  };
+
+  struct FlushStats {
+    uint64_t flushes = 0;
+    // Time from the last forced flush to its final result.
+    double last_latency_ms = 0.0;
+  };
+
+  struct LoadStats {
+    // aas_realtime_get_speedup() of the live session: above 1 april-asr is
+    // speeding audio up to keep up, at the cost of accuracy. Only sampled in
+    // Mode::AsyncRealtime; 0 otherwise.
+    float speedup = 0.0f;
+    // Running count of APRIL_RESULT_ERROR_CANT_KEEP_UP.
+    uint64_t cant_keep_up = 0;
+  };
+
+  struct SwapStats {
+    uint64_t swaps = 0;
+    // Swaps that found no pause in time and cut the utterance short.
+    uint64_t forced = 0;
+    // From stage_model() to the switch.
+    double last_wait_ms = 0.0;
+    // Audio fed to both sessions at the last switch.
+    double last_overlap_ms = 0.0;
+  };
+
+  AprilAsrEngine() = default;
+  AprilAsrEngine(const AprilAsrEngine &) = delete;
+  AprilAsrEngine &operator=(const AprilAsrEngine &) = delete;
+  ~AprilAsrEngine();
+
   bool load_model(const std::filesystem::path &model_path);
-  bool start();
+  // Uses an already loaded model, possibly shared with other engines.
+  bool set_model(std::shared_ptr<AprilModel> model);
+  std::shared_ptr<AprilModel> model() const;
+  // Mode for sessions created from now on.
+  void set_mode(Mode mode);
+  Mode mode() const { return mode_; }
+  // Coalesces pushed audio into chunks of this length before it reaches
+  // april-asr; the remainder waits for the next push or flush. 0 passes each
+  // push straight through. Only while nothing feeds audio.
+  void set_chunk_ms(unsigned ms);
+  unsigned chunk_ms() const { return chunk_ms_; }
+  // Also switches a running session of another mode.
+  bool start(Mode mode = Mode::AsyncRealtime);
+  // Frees the session and releases the model. Unpolled results are dropped.
   void stop();
-  void push_audio(const std::vector<float> &samples);
+
+  // Session lifecycle; the model stays loaded throughout. Only while nothing
+  // feeds audio.
+  //
+  // Starts over with a fresh session, taken from the spare when one is ready.
+  // A session that has not heard anything yet is kept. With `keep_tail`, an
+  // unfinished utterance is flushed into the results first; without, or when
+  // no partial is pending, the flush is skipped.
+  bool restart_session(bool keep_tail = true);
+  // Frees the session but keeps the model and unpolled results. A pending
+  // swap is completed first.
+  void stop_session(bool keep_tail = true);
+  // Keeps a second session created ahead for restart_session().
+  void keep_spare(bool enabled);
+  bool has_session() const { return has_session_.load(std::memory_order_acquire); }
+
+  // Builds a session on `model` while the current one keeps decoding, and
+  // switches to it at the next utterance boundary from the thread that feeds
+  // audio. Audio the old session heard after its last final is replayed into
+  // the new one, so nothing is lost or transcribed twice. The model must have
+  // the current sample rate. Staging again replaces a swap still pending.
+  bool stage_model(std::shared_ptr<AprilModel> model);
+  bool swap_pending() const;
+  // Switches to a staged session right away. Only while nothing feeds audio.
+  void complete_swap();
+  SwapStats swap_stats();
+  void push_audio(std::span<const float> samples);
+  void push_pcm16(std::span<const short> samples);
+  // Forces the current utterance to a final result. Does nothing unless a
+  // partial is pending. Call from the thread that feeds audio.
+  bool flush();
+  // True once after the engine itself reported silence.
+  bool take_silence_hint();
+  FlushStats flush_stats();
+  LoadStats load_stats() const;
   std::optional<std::string> poll_text();
+  std::optional<TimedText> poll_timed_text();
   std::optional<std::string> peek_partial();
   size_t sample_rate() const;
 
 private:
+  enum class SessionState {
+    Active,
+    // Swapped out with a flush; only its last final still counts.
+    Draining,
+    // Swapped out at a boundary; everything it still reports is dropped.
+    Retired,
+  };
+
+  // Passed to april-asr as userdata so results can be told apart per session.
+  struct Session {
+    AprilAsrEngine *owner = nullptr;
+    AprilASRSession handle = nullptr;
+    // april-asr needs every session freed before its model; the session
+    // holds on to the model until then.
+    std::shared_ptr<AprilModel> model;
+    Mode mode = Mode::AsyncRealtime;
+    std::atomic<SessionState> state{SessionState::Active};
+  };
+
   static void handler_trampoline(void *userdata, AprilResultType result, size_t count,
                                  const AprilToken *tokens);
-  void handle_result(AprilResultType result, size_t count, const AprilToken *tokens);
+  void handle_result(Session &session, AprilResultType result, size_t count, const AprilToken *tokens);
+  std::unique_ptr<Session> create_session(std::shared_ptr<AprilModel> model);
+  void free_session(std::unique_ptr<Session> session, bool keep_tail);
+  void reset_session_state();
+  void coalesce(const short *samples, size_t count);
+  void feed_remainder();
+  void feed(short *samples, size_t count);
+  void promote_staged(bool forced);
 
-  std::filesystem::path model_path_;
-  AprilASRModel model_{nullptr};
-  AprilASRSession session_{nullptr};
+  std::shared_ptr<AprilModel> model_;
+  std::unique_ptr<Session> session_;
+  // Whether session_ is set. A hot swap replaces session_ on the feeding
+  // thread but never clears it, so other threads check this instead.
+  std::atomic<bool> has_session_{false};
+  Mode mode_{Mode::AsyncRealtime};
+  // Created ahead on model_ in mode_; guarded by swap_mutex_ since a hot
+  // swap drops it from the feeding thread.
+  std::unique_ptr<Session> spare_;
+  bool keep_spare_ = false;
   size_t sample_rate_{16000};
-  std::queue<std::string> pending_;
+  std::queue<TimedText> pending_;
   std::optional<std::string> partial_;
   std::vector<short> pcm16_buffer_;
-  std::mutex mutex_;
+  unsigned chunk_ms_ = 0;
+  size_t chunk_samples_ = 0;
+  size_t chunk_fill_ = 0;
+  std::vector<short> chunk_buffer_;
+  std::optional<std::chrono::steady_clock::time_point> flush_time_;
+  FlushStats flush_stats_;
+  std::atomic<bool> silence_hint_{false};
+  std::atomic<float> speedup_{0.0f};
+  std::atomic<uint64_t> cant_keep_up_{0};
+  mutable std::mutex mutex_;
+
+  // Hot swap. The staged session is written by stage_model() and taken by
+  // the feeding thread under swap_mutex_.
+  std::unique_ptr<Session> staged_;
+  std::shared_ptr<AprilModel> staged_model_;
+  std::chrono::steady_clock::time_point staged_at_;
+  std::atomic<bool> swap_pending_{false};
+  std::mutex swap_mutex_;
+  // No partial text since the last final or silence.
+  std::atomic<bool> boundary_{true};
+  // Where the last final ended, in samples fed to the current session.
+  std::atomic<uint64_t> final_end_samples_{0};
+  uint64_t session_fed_ = 0;
+  uint64_t swap_fed_ = 0;
+  // The most recent audio fed, for replay into a swapped-in session.
+  std::vector<short> overlap_;
+  size_t overlap_pos_ = 0;
+  size_t overlap_filled_ = 0;
+  std::vector<short> replay_buffer_;
+  SwapStats swap_stats_;
 };
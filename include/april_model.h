@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+
+#include "april_api.h"
+
+// A loaded april-asr model. Any number of sessions may run on one model, so
+// it is shared; the handle is freed when the last owner lets go, which is
+// after every session on it.
+class AprilModel {
+public:
+  static std::shared_ptr<AprilModel> load(const std::filesystem::path &path);
+
+  ~AprilModel();
+  AprilModel(const AprilModel &) = delete;
+  AprilModel &operator=(const AprilModel &) = delete;
+
+  AprilASRModel handle() const { return handle_; }
+  size_t sample_rate() const { return sample_rate_; }
+  const std::filesystem::path &path() const { return path_; }
+
+private:
+  AprilModel(AprilASRModel handle, std::filesystem::path path);
+
+  AprilASRModel handle_;
+  size_t sample_rate_;
+  std::filesystem::path path_;
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "drift_compensator.h"
+#include "spsc_ring.h"
+#include "thread_policy.h"
+
+// Decouples the capture thread from the ASR engine. Capture callbacks write
+// into a preallocated PCM16 ring; a dedicated thread drains it into the sink.
+// While held, capture keeps filling the ring and the backlog is drained as
+// fast as the sink accepts it on resume. Outside a hold the backlog is kept
+// within a latency budget, so a slow sink cannot delay captions by the whole
+// ring. An optional auxiliary input on its
+// own clock is drift-compensated and mixed into the main one.
+class AudioFeeder {
+public:
+  using Sink = std::function<void(std::span<const short>)>;
+
+  struct Options {
+    bool mix_aux = false;
+    float main_gain = 1.0f;
+    float aux_gain = 1.0f;
+    // Aux backlog kept ahead of the main input to absorb scheduling jitter.
+    int aux_target_ms = 100;
+    // How long the drain thread sleeps when the ring is empty.
+    int poll_ms = 10;
+    // Longest piece of audio handed to the sink in one call; 0 hands over
+    // whole chunks. hold() waits for at most one piece, which matters when
+    // the sink decodes inline.
+    int slice_ms = 0;
+    // Backlog allowed outside a hold. free_space() only offers room up to it,
+    // and with drop_late a backlog that stays above it is cut back to it,
+    // oldest audio first. 0 allows the whole ring.
+    int max_latency_ms = 2000;
+    bool drop_late = true;
+    // Applied to the drain thread, which also runs the voice gate and feeds
+    // the engine.
+    ThreadPolicy thread_policy;
+  };
+
+  struct Stats {
+    size_t fill = 0;
+    size_t capacity = 0;
+    uint64_t overflow_samples = 0;
+    uint64_t overflow_events = 0;
+    // Audio dropped for exceeding the latency budget.
+    uint64_t late_samples = 0;
+    uint64_t late_events = 0;
+    bool held = false;
+    bool mixing = false;
+    size_t aux_fill = 0;
+    uint64_t aux_overflow_samples = 0;
+    DriftCompensator::Stats drift;
+    ThreadPolicyResult thread_policy;
+  };
+
+  bool start(size_t sample_rate, Sink sink, const Options &options);
+  void stop();
+  bool running() const;
+
+  // Pauses delivery to the sink. Returns once no sink call is in flight, so
+  // whatever the sink feeds may be torn down until resume(). Audio read but
+  // not yet delivered is kept for after resume().
+  void hold();
+  void resume();
+
+  // Realtime-safe: never allocate, lock or call into the sink. Float input is
+  // converted to PCM16 on the way in.
+  void write(std::span<const float> samples);
+  void write_pcm16(std::span<const short> samples);
+  // Same, for the auxiliary input. Ignored unless started with mix_aux.
+  void write_aux(std::span<const float> samples);
+  void write_aux_pcm16(std::span<const short> samples);
+
+  // Samples write() can take without dropping any. For producers that can
+  // wait instead of overflowing, such as a pipe.
+  size_t free_space() const;
+
+  Stats stats() const;
+
+private:
+  void run_loop();
+  void write_float(SpscRing<short> &ring, std::span<const float> samples);
+
+  Sink sink_;
+  Options options_;
+  SpscRing<short> ring_;
+  SpscRing<short> aux_ring_;
+  DriftCompensator drift_;
+  std::vector<short> chunk_;
+  std::vector<short> aux_chunk_;
+  size_t slice_samples_ = 0;
+  size_t budget_samples_ = 0;
+  std::atomic<uint64_t> late_samples_{0};
+  std::atomic<uint64_t> late_events_{0};
+  std::atomic<bool> running_{false};
+  std::atomic<bool> held_{false};
+  ThreadPolicyResult policy_result_;
+  std::atomic<bool> policy_applied_{false};
+  std::mutex sink_mutex_;
+  std::thread worker_;
+};
@@ -1,29 +1,59 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <mutex>
+#include <span>
 #include <vector>
 
+#include "capture_options.h"
+#include "downmix.h"
+#include "resampler.h"
+
 #ifdef HAVE_PIPEWIRE
 struct pw_thread_loop;
 struct pw_context;
 struct pw_stream;
+struct spa_pod;
 #endif
 
 class AudioLinux {
 public:
-  using SampleHandler = std::function<void(const std::vector<float> &)>;
+  using SampleHandler = std::function<void(std::span<const float>)>;
   // source: 0 = loopback (sink monitor), 1 = microphone/default source.
-  bool start(size_t sample_rate, int source, SampleHandler handler);
+  bool start(size_t sample_rate, int source, SampleHandler handler, const CaptureOptions &options = {});
   void stop();
+  CaptureStats stats() const;
 
 private:
   static void ensure_init();
   static void on_process(void *data);
+  // Realtime-side handoff, batching when options_.batch_ms is set.
+  void deliver(std::span<const float> samples);
+  void deliver_pcm16(std::span<const short> samples);
+#ifdef HAVE_PIPEWIRE
+  static void on_param_changed(void *data, uint32_t id, const spa_pod *param);
+#endif
+
+  // Conversion state for one negotiated format.
+  struct Dsp {
+    Downmixer downmix;
+    Resampler resampler;
+    std::vector<float> resampled;
+    // 0 until a usable format is negotiated.
+    uint32_t channels = 0;
+    // Mono PCM16 at sample_rate_, delivered untouched.
+    bool pcm16 = false;
+  };
+  // The slot on_process() may read; see dsp_.
+  Dsp *acquire_dsp();
+  void process_period(Dsp &dsp);
 
   SampleHandler handler_;
+  CaptureOptions options_;
   size_t sample_rate_ = 0;
   int source_ = 0;
   std::atomic<bool> running_{false};
@@ -34,5 +64,27 @@ private:
   pw_stream *stream_ = nullptr;
 #endif
 
+  // Format changes arrive on the loop thread while on_process() runs on the
+  // data thread. A new format is built in the slot the data thread is not
+  // using and then published through dsp_active_; dsp_in_use_ is the slot
+  // on_process() currently holds, -1 outside it.
+  Dsp dsp_[2];
+  std::atomic<int> dsp_active_{0};
+  std::atomic<int> dsp_in_use_{-1};
   std::vector<float> mono_;
+  size_t batch_frames_ = 0;
+  std::vector<float> batch_;
+  std::vector<short> batch_pcm16_;
+
+  ContinuityMonitor continuity_;
+  ThreadPolicyResult policy_result_;
+  std::atomic<bool> policy_applied_{false};
+  std::chrono::steady_clock::time_point started_;
+  std::atomic<uint64_t> wakeups_{0};
+  std::atomic<uint64_t> handoffs_{0};
+  std::atomic<uint32_t> period_frames_{0};
+  std::atomic<uint32_t> period_rate_{0};
+  std::atomic<uint32_t> format_changes_{0};
+  std::atomic<uint32_t> format_channels_{0};
+  std::atomic<bool> format_direct_{false};
 };
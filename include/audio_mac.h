@@ -2,11 +2,14 @@
 
 #include <cstddef>
 #include <functional>
-#include <vector>
+#include <span>
+
+#include "capture_options.h"
 
 class AudioMac {
 public:
-  using SampleHandler = std::function<void(const std::vector<float> &)>;
-  bool start(size_t sample_rate, int /*source*/, SampleHandler handler);
+  using SampleHandler = std::function<void(std::span<const float>)>;
+  bool start(size_t sample_rate, int /*source*/, SampleHandler handler, const CaptureOptions &options = {});
   void stop();
+  CaptureStats stats() const;
 };
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "capture_options.h"
+#include "downmix.h"
+#include "resampler.h"
+
+// Raw interleaved little-endian PCM from stdin ("-") or a named pipe, for
+// headless ingest from tools like ffmpeg or pw-record. Goes through the same
+// downmix and resample path as the device backends. The reader waits for
+// downstream space rather than queueing, so a fast producer is throttled by
+// the pipe itself.
+class AudioPipe {
+public:
+  enum class Format { S16LE, F32LE };
+  using SampleHandler = std::function<void(std::span<const float>)>;
+  // Samples the consumer can take right now.
+  using SpaceQuery = std::function<size_t()>;
+
+  struct Config {
+    std::string path = "-";
+    Format format = Format::S16LE;
+    uint32_t rate = 16000;
+    uint32_t channels = 1;
+    SpaceQuery free_space;
+  };
+
+  bool start(size_t sample_rate, const Config &config, SampleHandler handler, const CaptureOptions &options = {});
+  void stop();
+  bool running() const;
+  // True once the producer closed the pipe.
+  bool finished() const;
+  CaptureStats stats() const;
+
+  static bool parse_format(std::string_view text, Format &out);
+
+private:
+  void run_loop();
+  void deliver(std::span<const float> samples);
+  void deliver_pcm16(std::span<const short> samples);
+  bool wait_for_space(size_t samples);
+
+  Config config_;
+  SampleHandler handler_;
+  CaptureOptions options_;
+  size_t sample_rate_ = 0;
+  bool direct_pcm16_ = false;
+  std::atomic<bool> running_{false};
+  std::atomic<bool> finished_{false};
+  std::thread worker_;
+
+  Downmixer downmix_;
+  Resampler resampler_;
+  std::vector<uint8_t> raw_;
+  std::vector<float> interleaved_;
+  std::vector<float> mono_;
+  std::vector<float> resampled_;
+  std::vector<short> pcm16_;
+
+  ThreadPolicyResult policy_result_;
+  std::atomic<bool> policy_applied_{false};
+  std::chrono::steady_clock::time_point started_;
+  std::atomic<uint64_t> reads_{0};
+  std::atomic<uint64_t> handoffs_{0};
+  std::atomic<uint64_t> frames_{0};
+  std::atomic<uint32_t> read_frames_{0};
+};
@@ -1,30 +1,46 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <span>
 #include <thread>
 #include <vector>
 
 #include <audioclient.h>
 #include <wrl/client.h>
 
+#include "capture_options.h"
+
 class AudioWin {
 public:
   enum class Source { Loopback, Microphone };
-  using SampleHandler = std::function<void(const std::vector<float> &)>;
-  bool start(size_t sample_rate, Source source, SampleHandler handler);
+  using SampleHandler = std::function<void(std::span<const float>)>;
+  bool start(size_t sample_rate, Source source, SampleHandler handler, const CaptureOptions &options = {});
   void stop();
   bool running() const;
+  CaptureStats stats() const;
 
 private:
   void run_loop();
 
   SampleHandler handler_;
+  CaptureOptions options_;
   size_t sample_rate_ = 0;
   Source source_ = Source::Loopback;
   std::atomic<bool> running_{false};
   std::thread worker_;
   Microsoft::WRL::ComPtr<IAudioClient> client_;
   HANDLE capture_event_ = nullptr;
+
+  ContinuityMonitor continuity_;
+  ThreadPolicyResult policy_result_;
+  std::atomic<bool> policy_applied_{false};
+  std::chrono::steady_clock::time_point started_;
+  std::atomic<uint64_t> wakeups_{0};
+  std::atomic<uint64_t> handoffs_{0};
+  std::atomic<uint32_t> period_frames_{0};
+  std::atomic<uint32_t> period_rate_{0};
 };
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "april_model.h"
+#include "resampler.h"
+
+// Transcribes every .wav file in a directory, several files at a time, with
+// all sessions on one shared model. A journal in the output directory
+// records finished files, so an interrupted batch resumes where it stopped.
+class BatchTranscriber {
+public:
+  struct Options {
+    // Files decoded at once; 0 picks one per hardware thread.
+    unsigned jobs = 0;
+    // Where transcripts and the journal go; empty means the input directory.
+    std::filesystem::path output_dir;
+    Resampler::Quality resample_quality = Resampler::Quality::High;
+    const std::atomic<bool> *cancel = nullptr;
+  };
+
+  struct FileResult {
+    std::filesystem::path input;
+    std::filesystem::path output;
+    bool ok = false;
+    bool skipped = false;
+    std::string error;
+    double audio_seconds = 0.0;
+    double wall_seconds = 0.0;
+    size_t segments = 0;
+
+    double realtime_factor() const { return audio_seconds > 0.0 ? wall_seconds / audio_seconds : 0.0; }
+  };
+  // Called once per file, from worker threads but never concurrently.
+  using FileHandler = std::function<void(const FileResult &)>;
+
+  struct Summary {
+    size_t files = 0;
+    size_t skipped = 0;
+    size_t failed = 0;
+    double audio_seconds = 0.0;
+    double wall_seconds = 0.0;
+
+    double realtime_factor() const { return audio_seconds > 0.0 ? wall_seconds / audio_seconds : 0.0; }
+  };
+
+  bool run(const std::shared_ptr<AprilModel> &model, const std::filesystem::path &input_dir, const Options &options,
+           const FileHandler &on_file, Summary &summary, std::string &error);
+
+  static constexpr const char *kJournalName = ".transcribe-journal";
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <span>
+
+#include "continuity_monitor.h"
+#include "resampler.h"
+#include "thread_policy.h"
+
+// Tuning shared by every capture backend.
+struct CaptureOptions {
+  using Pcm16Handler = std::function<void(std::span<const short>)>;
+
+  Resampler::Quality resample_quality = Resampler::Quality::Balanced;
+  // When set, backends that can negotiate mono PCM16 at the target rate
+  // deliver it here untouched instead of through the float handler. Where
+  // the audio graph converts to it (PipeWire), that replaces the Downmixer
+  // and Resampler with the graph's own conversion.
+  Pcm16Handler pcm16_handler;
+  // Requested device period; 0 leaves it to the audio graph.
+  int latency_ms = 0;
+  // Audio is collected for this long before being handed downstream; 0
+  // hands off every period.
+  int batch_ms = 0;
+  // Applied to the capture callback thread on its first period.
+  ThreadPolicy thread_policy;
+};
+
+// Averages since start, except the period which is the latest one seen.
+struct CaptureStats {
+  double wakeups_per_sec = 0.0;
+  double handoffs_per_sec = 0.0;
+  uint32_t period_frames = 0;
+  uint32_t period_rate = 0;
+  // For backends that learn the capture format after start(): bumped per
+  // negotiation so the UI thread can log it. Channels are 0 for a format
+  // that cannot be converted; direct means mono PCM16 passed untouched.
+  uint32_t format_changes = 0;
+  uint32_t format_channels = 0;
+  bool format_direct = false;
+  ContinuityMonitor::Counters continuity;
+  ThreadPolicyResult thread_policy;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Checks that a capture stream delivered every frame. Each period is checked
+// against the device position when the audio API reports one, otherwise
+// against the wall clock with a jitter allowance. Called from the capture
+// thread; counters() may be read from any thread.
+class ContinuityMonitor {
+public:
+  struct Counters {
+    // Frames delivered, at the device rate.
+    uint64_t frames = 0;
+    uint64_t periods = 0;
+    uint64_t gaps = 0;
+    uint64_t lost_frames = 0;
+    // Periods the audio API flagged as discontinuous or corrupted.
+    uint64_t discontinuities = 0;
+    uint32_t rate = 0;
+  };
+
+  void reset();
+  // Restarts the comparison; the counters carry on.
+  void set_rate(uint32_t rate);
+  // Streams that legitimately stop delivering while idle, such as WASAPI
+  // loopback, only count short flagged jumps as gaps.
+  void set_intermittent(bool intermittent);
+
+  // Realtime-safe. Both return the frames judged missing before this period.
+  uint64_t on_period(uint32_t frames, bool flagged);
+  uint64_t on_period_at(uint32_t frames, uint64_t device_position, bool flagged);
+
+  Counters counters() const;
+
+private:
+  void count_period(uint32_t frames, bool flagged);
+  void record_gap(uint64_t lost);
+
+  std::atomic<uint32_t> rate_{0};
+  std::atomic<bool> restart_{true};
+  bool intermittent_ = false;
+
+  // Capture-thread state.
+  std::chrono::steady_clock::time_point last_time_;
+  double lag_ = 0.0;
+  double baseline_ = 0.0;
+  double suspect_ = 0.0;
+  uint64_t next_position_ = 0;
+
+  std::atomic<uint64_t> frames_{0};
+  std::atomic<uint64_t> periods_{0};
+  std::atomic<uint64_t> gaps_{0};
+  std::atomic<uint64_t> lost_frames_{0};
+  std::atomic<uint64_t> discontinuities_{0};
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+// Compile-time SIMD availability shared by the DSP kernels. x86 builds
+// compile AVX2 variants with a per-function target attribute and pick them at
+// runtime; NEON is baseline on AArch64.
+#if defined(__x86_64__) || defined(_M_X64)
+#define SIMD_X86 1
+#if defined(__GNUC__) || defined(__clang__)
+#define SIMD_AVX2 1
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SIMD_NEON 1
+#endif
+
+struct CpuFeatures {
+  bool sse2 = false;
+  bool avx2 = false;
+  bool neon = false;
+};
+
+const CpuFeatures &cpu_features();
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+enum class ChannelPosition {
+  Unknown,
+  Mono,
+  FrontLeft,
+  FrontRight,
+  FrontCenter,
+  LowFrequency,
+  FrontLeftCenter,
+  FrontRightCenter,
+  SideLeft,
+  SideRight,
+  RearLeft,
+  RearRight,
+  RearCenter,
+};
+
+// Folds interleaved multichannel audio to mono. Weights favour the channels
+// that carry dialogue (center first, then front) and drop LFE; they are
+// normalized to sum to one so the mix cannot clip.
+class Downmixer {
+public:
+  static constexpr size_t kMaxChannels = 64;
+
+  // An empty layout selects the default layout for the channel count.
+  bool configure(size_t channels, std::span<const ChannelPosition> layout = {});
+  size_t channels() const { return channels_; }
+  float weight(size_t channel) const { return weights_[channel]; }
+
+  // `mono` receives `frames` samples; `interleaved` holds frames * channels().
+  void process(const float *interleaved, size_t frames, float *mono) const;
+
+  static std::vector<ChannelPosition> default_layout(size_t channels);
+
+private:
+  size_t channels_ = 0;
+  alignas(32) std::array<float, kMaxChannels> weights_{};
+};
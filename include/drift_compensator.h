@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "spsc_ring.h"
+
+// Reads a secondary PCM16 stream out of its ring at the pace of a primary
+// stream that runs on a different clock. A PI controller steers the read
+// ratio so that the secondary backlog stays a fixed target ahead of the
+// primary's; a 4-point cubic interpolator applies the fractional ratio. The
+// controller's integral term converges on the clock drift between the two.
+class DriftCompensator {
+public:
+  struct Stats {
+    bool locked = false;
+    double drift_ppm = 0.0;
+    // Smoothed secondary backlog relative to the primary's.
+    double offset_ms = 0.0;
+    double target_ms = 0.0;
+    uint64_t underruns = 0;
+    uint64_t resyncs = 0;
+  };
+
+  // Not thread-safe: call while process() is idle.
+  void configure(size_t sample_rate, size_t target_samples, size_t max_block);
+  void reset();
+
+  // Consumer side of `ring`. Fills `out` completely, with silence while the
+  // secondary has not buffered enough. `lead` is the primary backlog still
+  // queued behind this block.
+  void process(SpscRing<short> &ring, size_t lead, std::span<short> out);
+
+  Stats stats() const;
+
+private:
+  bool prime(SpscRing<short> &ring, size_t lead);
+
+  size_t sample_rate_ = 0;
+  size_t target_ = 0;
+  std::vector<short> history_;
+  size_t history_len_ = 0;
+  double pos_ = 0.0;
+  bool primed_ = false;
+  double error_ms_ = 0.0;
+  double integral_ppm_ = 0.0;
+
+  std::atomic<bool> locked_{false};
+  std::atomic<double> drift_ppm_{0.0};
+  std::atomic<double> offset_ms_{0.0};
+  std::atomic<uint64_t> underruns_{0};
+  std::atomic<uint64_t> resyncs_{0};
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "april_asr.h"
+#include "april_model.h"
+
+// Replays a recording into a session paced like live capture, to compare
+// engine modes, feed chunk sizes and forced finals on one machine: how long
+// finals take after their audio was captured, how much CPU the process
+// burns, and how far the transcript drifts from a reference.
+class EngineBenchmark {
+public:
+  struct Config {
+    AprilAsrEngine::Mode mode = AprilAsrEngine::Mode::AsyncRealtime;
+    unsigned chunk_ms = 0;
+    // Forces a final after this much silence, through the voice gate's pause
+    // detection and the engine's silence hint as live captioning does; 0
+    // leaves finals to april-asr.
+    int finalize_pause_ms = 0;
+  };
+
+  struct Result {
+    Config config;
+    double audio_seconds = 0.0;
+    double wall_seconds = 0.0;
+    double cpu_seconds = 0.0;
+    size_t finals = 0;
+    // From when a final's last word was captured, i.e. the end of speech, to
+    // when it was polled.
+    double mean_latency_ms = 0.0;
+    double p95_latency_ms = 0.0;
+    float max_speedup = 0.0f;
+    uint64_t cant_keep_up = 0;
+    uint64_t forced_finals = 0;
+    std::string transcript;
+    // Against the reference; negative without one.
+    double word_error_rate = -1.0;
+
+    // Process CPU time per second of audio, in percent of one core.
+    double cpu_percent() const { return audio_seconds > 0.0 ? 100.0 * cpu_seconds / audio_seconds : 0.0; }
+  };
+
+  // Reads up to `max_seconds` (0: all) of a WAV file as mono PCM16 at `rate`.
+  static bool load_audio(const std::filesystem::path &path, size_t rate, double max_seconds, std::vector<short> &out,
+                         std::string &error);
+  // Decodes as fast as the CPU allows in one synchronous session. The
+  // accuracy baseline when no reference text is given.
+  static std::string transcribe(const std::shared_ptr<AprilModel> &model, std::span<const short> audio);
+  // Feeds `audio` in realtime, 10 ms at a time as capture would.
+  static bool run(const std::shared_ptr<AprilModel> &model, std::span<const short> audio, const Config &config,
+                  Result &result);
+  // Word edit distance over the reference length. Case and punctuation do
+  // not count.
+  static double word_error_rate(const std::string &reference, const std::string &hypothesis);
+  static const char *mode_name(AprilAsrEngine::Mode mode);
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "april_model.h"
+
+// Recently used models kept loaded, so switching back to one only costs a
+// new session. Least recently used models are dropped once the total size
+// passes the budget. A dropped model still in use stays alive with its
+// sessions; the cache just stops holding it.
+class ModelCache {
+public:
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t entries = 0;
+    // Estimated from model file sizes; weights dominate a loaded model.
+    uint64_t resident_bytes = 0;
+    uint64_t budget_bytes = 0;
+    double last_load_ms = 0.0;
+  };
+
+  explicit ModelCache(uint64_t budget_bytes = 0);
+
+  // 0 keeps only the most recently used model.
+  void set_budget(uint64_t budget_bytes);
+  // Returns the cached model, or loads it. A file changed since it was
+  // cached (e.g. reinstalled) is loaded again. Safe from any thread.
+  std::shared_ptr<AprilModel> get(const std::filesystem::path &path);
+  // Whether get() would return without loading. Does not count as a use.
+  bool contains(const std::filesystem::path &path) const;
+  // Drops one model, e.g. before its file is replaced.
+  void erase(const std::filesystem::path &path);
+  // Drops models whose files are no longer in `available`.
+  void prune(const std::vector<std::filesystem::path> &available);
+  void clear();
+  Stats stats() const;
+
+private:
+  struct Entry {
+    std::filesystem::path path;
+    std::shared_ptr<AprilModel> model;
+    uint64_t bytes = 0;
+    std::filesystem::file_time_type mtime;
+  };
+
+  void evict_locked();
+
+  // Most recently used first.
+  std::list<Entry> entries_;
+  Stats stats_;
+  mutable std::mutex mutex_;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "april_model.h"
+#include "model_cache.h"
+#include "model_prefetcher.h"
+
+// Loads models through the cache on a background thread so the UI never
+// waits on aam_create_model. Only the newest request counts: asking for
+// another model, or cancel(), discards whatever is loading. A load already
+// inside april-asr cannot be interrupted, but its result is dropped (and
+// stays cached). With a prefetcher, a model not cached yet is also read
+// ahead from the moment it is requested.
+class ModelLoader {
+public:
+  struct Ready {
+    uint64_t generation = 0;
+    std::filesystem::path path;
+    // Null if loading failed.
+    std::shared_ptr<AprilModel> model;
+    bool cache_hit = false;
+    double wait_ms = 0.0;
+  };
+
+  explicit ModelLoader(ModelCache &cache, ModelPrefetcher *prefetcher = nullptr);
+  ~ModelLoader();
+  ModelLoader(const ModelLoader &) = delete;
+  ModelLoader &operator=(const ModelLoader &) = delete;
+
+  uint64_t request(const std::filesystem::path &path);
+  void cancel();
+  // The newest request's result, once it is ready.
+  std::optional<Ready> poll();
+  // The newest requested model until its result is ready.
+  std::optional<std::filesystem::path> pending() const;
+
+private:
+  void run_loop();
+
+  ModelCache &cache_;
+  ModelPrefetcher *prefetcher_;
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  uint64_t generation_ = 0;
+  std::optional<std::filesystem::path> requested_;
+  std::optional<std::filesystem::path> pending_;
+  std::optional<Ready> ready_;
+  bool stopping_ = false;
+  std::thread worker_;
+};
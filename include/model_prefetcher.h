@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+// Reads model files through on a background thread so aam_create_model finds
+// them in the OS page cache instead of waiting on the disk. The model the user
+// picked goes first and interrupts background warming of models likely to be
+// picked next.
+class ModelPrefetcher {
+public:
+  struct Stats {
+    uint64_t files = 0;
+    uint64_t bytes = 0;
+    std::filesystem::path last_path;
+    double last_ms = 0.0;
+    uint64_t last_bytes = 0;
+  };
+
+  ModelPrefetcher();
+  ~ModelPrefetcher();
+  ModelPrefetcher(const ModelPrefetcher &) = delete;
+  ModelPrefetcher &operator=(const ModelPrefetcher &) = delete;
+
+  // Reads `path` next, ahead of anything queued.
+  void prefetch(const std::filesystem::path &path);
+  // Replaces the models to read once nothing more urgent is pending.
+  void warm(std::vector<std::filesystem::path> paths);
+  // Drops queued work and interrupts the current read.
+  void cancel();
+  // True once `path` was read in full and has not changed since. The OS may
+  // still have dropped the pages under memory pressure.
+  bool warmed(const std::filesystem::path &path) const;
+  // The file being read, if any.
+  std::optional<std::filesystem::path> current() const;
+  Stats stats() const;
+
+  // Reads a file through once, hinting the OS to read ahead. Stops early when
+  // `abort` is set. Returns the bytes read, or nullopt if it cannot be opened.
+  static std::optional<uint64_t> read_through(const std::filesystem::path &path, const std::atomic<bool> *abort = nullptr);
+  // Drops a file's pages from the page cache so the next load is cold. Linux
+  // only; false elsewhere.
+  static bool evict(const std::filesystem::path &path);
+
+private:
+  struct FileStamp {
+    uint64_t bytes = 0;
+    std::filesystem::file_time_type mtime;
+  };
+
+  void run_loop();
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::filesystem::path> queue_;
+  std::optional<std::filesystem::path> current_;
+  std::map<std::filesystem::path, FileStamp> warmed_;
+  std::atomic<bool> interrupt_{false};
+  bool stopping_ = false;
+  Stats stats_;
+  std::thread worker_;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "april_asr.h"
+#include "april_model.h"
+#include "resampler.h"
+
+// Transcribes a WAV file through synchronous sessions, as fast as the CPU
+// decodes rather than at capture pace. Each final is reported with its
+// position in the file. With several jobs the file is cut at pauses into
+// chunks decoded in parallel on one shared model.
+class OfflineTranscriber {
+public:
+  using SegmentHandler = std::function<void(const AprilAsrEngine::TimedText &)>;
+  // Fraction of the file decoded so far.
+  using ProgressHandler = std::function<void(double)>;
+
+  struct Options {
+    Resampler::Quality resample_quality = Resampler::Quality::High;
+    // Parallel sessions; 0 picks one per hardware thread.
+    unsigned jobs = 1;
+    // Set from another thread to abandon the file.
+    const std::atomic<bool> *cancel = nullptr;
+    ProgressHandler on_progress;
+  };
+
+  struct Result {
+    double audio_seconds = 0.0;
+    double wall_seconds = 0.0;
+    size_t segments = 0;
+    size_t chunks = 0;
+    unsigned jobs = 0;
+
+    // Wall time per second of audio; below 1 is faster than realtime.
+    double realtime_factor() const { return audio_seconds > 0.0 ? wall_seconds / audio_seconds : 0.0; }
+  };
+
+  // Segments and progress arrive in file order, possibly from worker threads
+  // but never concurrently.
+  bool run(const std::shared_ptr<AprilModel> &model, const std::filesystem::path &path, const Options &options,
+           const SegmentHandler &on_segment, Result &result, std::string &error);
+};
+
+// "hh:mm:ss.mmm"
+std::string format_offset_ms(size_t ms);
+// "[hh:mm:ss.mmm --> hh:mm:ss.mmm] text", one transcript line.
+std::string format_segment(const AprilAsrEngine::TimedText &segment);
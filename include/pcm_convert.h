@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+
+// Float samples are clamped to [-1, 1], scaled by 32767 and rounded to
+// nearest-even. NaN maps to 0. Every kernel produces bit-identical output to
+// float_to_pcm16_scalar; float_to_pcm16 dispatches on the running CPU.
+void float_to_pcm16(const float *in, short *out, size_t count);
+void float_to_pcm16_scalar(const float *in, short *out, size_t count);
+
+// out = a * gain_a + b * gain_b, rounded to nearest-even and saturated to
+// 16 bits. out may alias a or b. Every kernel matches mix_pcm16_scalar
+// exactly.
+void mix_pcm16(const short *a, float gain_a, const short *b, float gain_b, short *out, size_t count);
+void mix_pcm16_scalar(const short *a, float gain_a, const short *b, float gain_b, short *out, size_t count);
+
+// Name of the kernel float_to_pcm16 and mix_pcm16 dispatch to ("avx2", "sse2", "neon" or "scalar").
+const char *pcm_convert_kernel_name();
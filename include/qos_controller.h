@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+// Decides how far to back off when recognition cannot keep up with realtime.
+// Fed the engine's speedup and keep-up errors about once a second, it steps up
+// one level after a sustained overload and back down one level after a much
+// longer healthy stretch, so short spikes and recoveries do not make it flap.
+// Applying a level is up to the caller.
+class QosController {
+public:
+  enum class Level {
+    Normal,
+    // Fewer UI frames leave more CPU to the recognizer.
+    ReducedUi,
+    // Silence is no longer decoded.
+    SkipSilence,
+    // A smaller model of the same language.
+    LighterModel,
+  };
+
+  struct Config {
+    // Smoothed speedup above which the recognizer is behind...
+    float overload_speedup = 1.1f;
+    // ...and at or below which it has headroom again.
+    float healthy_speedup = 1.0f;
+    std::chrono::milliseconds escalate_after{5000};
+    std::chrono::milliseconds recover_after{30000};
+  };
+
+  struct Decision {
+    Level from = Level::Normal;
+    Level to = Level::Normal;
+    std::string reason;
+  };
+
+  QosController() = default;
+  explicit QosController(const Config &config) : config_(config) {}
+
+  // `cant_keep_up` is the engine's running count of keep-up errors.
+  std::optional<Decision> update(float speedup, uint64_t cant_keep_up, std::chrono::steady_clock::time_point now);
+  // Starts over at `level`, e.g. after the user picked a model.
+  void reset(Level level = Level::Normal);
+  // Highest level update() may step up to, e.g. when no lighter model exists.
+  void set_max_level(Level level) { max_level_ = level; }
+  Level level() const { return level_; }
+  // Smoothed speedup, 0 until sampled.
+  float speedup() const { return smoothed_; }
+
+  static const char *name(Level level);
+
+private:
+  Config config_;
+  Level level_ = Level::Normal;
+  Level max_level_ = Level::LighterModel;
+  float smoothed_ = 0.0f;
+  std::optional<uint64_t> last_errors_;
+  // Keep-up errors since the current overload began.
+  uint64_t overload_errors_ = 0;
+  std::optional<std::chrono::steady_clock::time_point> overloaded_since_;
+  std::optional<std::chrono::steady_clock::time_point> healthy_since_;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+// Streaming rational resampler built from a Kaiser-windowed sinc split into
+// polyphase branches. Phase and filter history carry across process() calls,
+// so packet boundaries are seamless.
+class Resampler {
+public:
+  enum class Quality { Fast, Balanced, High };
+
+  bool configure(size_t in_rate, size_t out_rate, Quality quality = Quality::Balanced);
+  // Preallocates for inputs of up to `max_in_frames` so process() does not allocate.
+  void reserve(size_t max_in_frames);
+  void reset();
+
+  // Replaces `out` with the resampled output for `in`.
+  void process(std::span<const float> in, std::vector<float> &out);
+
+  bool passthrough() const { return up_ == down_; }
+  size_t in_rate() const { return in_rate_; }
+  size_t out_rate() const { return out_rate_; }
+  size_t taps() const { return taps_; }
+
+private:
+  size_t in_rate_ = 0;
+  size_t out_rate_ = 0;
+  size_t up_ = 1;
+  size_t down_ = 1;
+  size_t taps_ = 0;
+  // up_ branches of taps_ coefficients, ordered oldest sample first.
+  std::vector<float> coeffs_;
+  // taps_ - 1 samples of history followed by pending input.
+  std::vector<float> buffer_;
+  // Position of the next output in buffer_, in units of 1/up_ samples.
+  size_t pos_ = 0;
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Wait-free single-producer/single-consumer ring buffer. Storage is allocated
+// by reset(); write() and read() never allocate, lock or block. Samples that
+// do not fit are dropped and counted as overflow.
+template <typename T>
+class SpscRing {
+public:
+  // Not thread-safe: call only while neither side is active.
+  void reset(size_t min_capacity) {
+    size_t cap = 1;
+    while (cap < min_capacity) {
+      cap <<= 1;
+    }
+    buffer_ = std::make_unique<T[]>(cap);
+    mask_ = cap - 1;
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+    overflow_samples_.store(0, std::memory_order_relaxed);
+    overflow_events_.store(0, std::memory_order_relaxed);
+  }
+
+  // Producer side.
+  size_t write(const T *data, size_t count) {
+    if (!buffer_) {
+      return 0;
+    }
+    const size_t head = head_.load(std::memory_order_relaxed);
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    const size_t free = capacity() - (head - tail);
+    const size_t n = std::min(count, free);
+    const size_t start = head & mask_;
+    const size_t first = std::min(n, capacity() - start);
+    std::copy(data, data + first, buffer_.get() + start);
+    std::copy(data + first, data + n, buffer_.get());
+    head_.store(head + n, std::memory_order_release);
+    if (n < count) {
+      overflow_samples_.store(overflow_samples_.load(std::memory_order_relaxed) + (count - n),
+                              std::memory_order_relaxed);
+      overflow_events_.store(overflow_events_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    return n;
+  }
+
+  // Consumer side.
+  size_t read(T *out, size_t count) {
+    if (!buffer_) {
+      return 0;
+    }
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t head = head_.load(std::memory_order_acquire);
+    const size_t n = std::min(count, head - tail);
+    const size_t start = tail & mask_;
+    const size_t first = std::min(n, capacity() - start);
+    std::copy(buffer_.get() + start, buffer_.get() + start + first, out);
+    std::copy(buffer_.get(), buffer_.get() + (n - first), out + first);
+    tail_.store(tail + n, std::memory_order_release);
+    return n;
+  }
+
+  // Consumer side. Discards up to `count` of the oldest samples.
+  size_t skip(size_t count) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t head = head_.load(std::memory_order_acquire);
+    const size_t n = std::min(count, head - tail);
+    tail_.store(tail + n, std::memory_order_release);
+    return n;
+  }
+
+  size_t size() const {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+  size_t capacity() const { return buffer_ ? mask_ + 1 : 0; }
+  uint64_t overflow_samples() const { return overflow_samples_.load(std::memory_order_relaxed); }
+  uint64_t overflow_events() const { return overflow_events_.load(std::memory_order_relaxed); }
+
+private:
+  static constexpr size_t kCacheLine = 64;
+
+  std::unique_ptr<T[]> buffer_;
+  size_t mask_ = 0;
+  alignas(kCacheLine) std::atomic<size_t> head_{0};
+  alignas(kCacheLine) std::atomic<size_t> tail_{0};
+  alignas(kCacheLine) std::atomic<uint64_t> overflow_samples_{0};
+  std::atomic<uint64_t> overflow_events_{0};
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Scheduling class, priority and CPU affinity for one of our threads. Written
+// in settings.ini as "<scheduler>[:<priority>][@<cpus>]", e.g. "fifo:20@2-3",
+// "nice:-5" or "default@0,1".
+struct ThreadPolicy {
+  enum class Scheduler { Default, Nice, Fifo, RoundRobin };
+
+  Scheduler scheduler = Scheduler::Default;
+  // Nice value for Nice, 1-99 for Fifo and RoundRobin.
+  int priority = 0;
+  // Empty means any CPU.
+  std::vector<int> cpus;
+
+  bool is_default() const { return scheduler == Scheduler::Default && cpus.empty(); }
+};
+
+// What apply_thread_policy() managed to do. Error codes are errno values
+// (GetLastError() on Windows); 0 means success or not requested.
+struct ThreadPolicyResult {
+  bool attempted = false;
+  int scheduler_error = 0;
+  int affinity_error = 0;
+};
+
+bool parse_thread_policy(std::string_view text, ThreadPolicy &out);
+std::string format_thread_policy(const ThreadPolicy &policy);
+
+// Applies the policy to the calling thread. Does not allocate, so it may run
+// on a realtime thread. A part that is refused is left at its default.
+// Default parts are restored rather than left alone, to the scheduling,
+// nice value and CPUs the first caller had before its own policy.
+ThreadPolicyResult apply_thread_policy(const ThreadPolicy &policy);
+
+// Runs the calling thread with default scheduling for the scope and then puts
+// its own policy back. On Linux a new thread inherits its creator's
+// scheduling class, nice value and affinity, so threads started from one
+// with a policy, including those april-asr and PipeWire start for us, are
+// started inside one of these. Raising a nice value back needs privileges, so
+// a positive one is still inherited without them.
+class DefaultThreadPolicyScope {
+public:
+  DefaultThreadPolicyScope();
+  ~DefaultThreadPolicyScope();
+  DefaultThreadPolicyScope(const DefaultThreadPolicyScope &) = delete;
+  DefaultThreadPolicyScope &operator=(const DefaultThreadPolicyScope &) = delete;
+
+private:
+#if !defined(_WIN32)
+  int sched_ = 0;
+  sched_param param_{};
+  int nice_ = 0;
+#if defined(__linux__)
+  cpu_set_t cpus_{};
+  bool have_cpus_ = false;
+#endif
+#endif
+};
+
+// One-line report for the log, e.g. "fifo:20@2-3 (scheduler denied: 1)".
+std::string describe_thread_policy(const ThreadPolicy &policy, const ThreadPolicyResult &result);
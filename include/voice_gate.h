@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+// Energy-based voice activity gate for PCM16 audio. While no speech is
+// present audio is held back from the sink. A pre-roll window is replayed
+// when speech starts and a hangover keeps the gate open after it ends, so
+// word onsets and tails are not clipped. The same detector reports
+// end-of-utterance pauses, independently of gating.
+class VoiceGate {
+public:
+  using Sink = std::function<void(std::span<const short>)>;
+  using PauseHandler = std::function<void()>;
+
+  struct Config {
+    bool enabled = false;
+    int hangover_ms = 500;
+    int preroll_ms = 300;
+    // Speech must exceed the tracked noise floor by this much...
+    float threshold_db = 9.0f;
+    // ...and this absolute level.
+    float min_speech_dbfs = -55.0f;
+    // Silence after speech that counts as an utterance boundary; 0 disables.
+    int pause_ms = 0;
+  };
+
+  struct Stats {
+    uint64_t processed_samples = 0;
+    uint64_t skipped_samples = 0;
+    uint64_t pauses = 0;
+    bool open = false;
+  };
+
+  // Not thread-safe: call while process() is idle.
+  // `on_pause` runs on the processing thread after all audio preceding the
+  // pause has been handed to the sink.
+  void configure(size_t sample_rate, const Config &config, Sink sink, PauseHandler on_pause = {});
+  void reset();
+  // Gates silence even when the config does not, e.g. while the CPU cannot
+  // keep up. Safe from any thread.
+  void force_gating(bool forced);
+
+  void process(std::span<const short> samples);
+  Stats stats() const;
+
+private:
+  void process_frame(const short *frame);
+  void gate_frame(const short *frame, bool speech);
+  void push_preroll(const short *frame);
+  // Gating was just turned off, by the config or force_gating().
+  void stop_gating();
+  void emit();
+  bool gating() const { return config_.enabled || forced_.load(std::memory_order_relaxed); }
+
+  Config config_;
+  Sink sink_;
+  PauseHandler on_pause_;
+  size_t frame_samples_ = 0;
+  size_t hangover_frames_ = 0;
+  size_t hang_left_ = 0;
+  size_t pause_frames_ = 0;
+  size_t silence_frames_ = 0;
+  bool speech_since_pause_ = false;
+  float noise_db_ = 0.0f;
+  bool noise_init_ = false;
+  bool open_ = false;
+  // Whether the previous process() gated.
+  bool gated_ = false;
+  std::vector<short> pending_;
+  std::vector<short> out_;
+  std::vector<short> preroll_;
+  size_t preroll_head_ = 0;
+  size_t preroll_fill_ = 0;
+  std::atomic<uint64_t> processed_{0};
+  std::atomic<uint64_t> skipped_{0};
+  std::atomic<uint64_t> pauses_{0};
+  std::atomic<bool> open_flag_{false};
+  std::atomic<bool> forced_{false};
+};
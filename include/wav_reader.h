@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Streaming reader for RIFF/WAVE files: 8/16/24/32-bit integer PCM and
+// 32-bit float, plain or WAVE_FORMAT_EXTENSIBLE. Only one block is held in
+// memory, so hour-long recordings cost nothing extra.
+class WavReader {
+public:
+  enum class Encoding { Pcm8, Pcm16, Pcm24, Pcm32, Float32 };
+
+  bool open(const std::filesystem::path &path, std::string &error);
+  void close();
+
+  // Reads up to `max_frames` interleaved frames scaled to [-1, 1). Returns
+  // the frames read; 0 at the end of the data.
+  size_t read(float *interleaved, size_t max_frames);
+  // Pcm16 files only: samples as stored.
+  size_t read_pcm16(short *interleaved, size_t max_frames);
+  bool seek(uint64_t frame);
+
+  uint32_t rate() const { return rate_; }
+  uint32_t channels() const { return channels_; }
+  Encoding encoding() const { return encoding_; }
+  uint64_t frames() const { return frames_; }
+  uint64_t position() const { return position_; }
+
+private:
+  size_t read_raw(size_t max_frames);
+
+  std::ifstream stream_;
+  uint32_t rate_ = 0;
+  uint32_t channels_ = 0;
+  uint32_t block_align_ = 0;
+  Encoding encoding_ = Encoding::Pcm16;
+  uint64_t data_offset_ = 0;
+  uint64_t frames_ = 0;
+  uint64_t position_ = 0;
+  std::vector<uint8_t> raw_;
+};
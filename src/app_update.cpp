@@ -11,6 +11,8 @@
 #include <vector>
 #include <curl/curl.h>
 
+#include "thread_policy.h"
+
 #if defined(_WIN32)
 #include <windows.h>
 #include <shellapi.h>
@@ -160,6 +162,7 @@ void start_update_check(UpdateState &state, bool show_modal) {
     state.result = UpdateResult{};
   }
 
+  const DefaultThreadPolicyScope default_policy;
   state.worker = std::thread([&state]() {
     UpdateResult r = fetch_latest_release();
     std::lock_guard<std::mutex> lock(state.mutex);
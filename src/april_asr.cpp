@@ -1,82 +1,453 @@
 #include "april_asr.h"
 
 #include <algorithm>
-#include <cmath>
-#include <mutex>
+#include <cstdio>
+
+#include "pcm_convert.h"
+#include "thread_policy.h"
 
 namespace {
-std::once_flag g_once;
+// Longest stretch of audio replayed into a swapped-in session.
+constexpr size_t kOverlapMs = 2000;
+// A staged swap waits this much audio for a pause before forcing a final.
+constexpr size_t kSwapTimeoutMs = 8000;
+}  // namespace
+
+AprilAsrEngine::~AprilAsrEngine() {
+  stop();
 }
 
 bool AprilAsrEngine::load_model(const std::filesystem::path &model_path) {
   stop();
+  return set_model(AprilModel::load(model_path));
+}
 
-  std::call_once(g_once, [] { aam_api_init(APRIL_VERSION); });
-
-  model_path_ = model_path;
-  if (!std::filesystem::exists(model_path_)) {
+bool AprilAsrEngine::set_model(std::shared_ptr<AprilModel> model) {
+  stop();
+  if (!model) {
     return false;
   }
+  model_ = std::move(model);
+  sample_rate_ = model_->sample_rate();
+  return true;
+}
+
+std::shared_ptr<AprilModel> AprilAsrEngine::model() const {
+  std::scoped_lock lock(mutex_);
+  return model_;
+}
+
+std::unique_ptr<AprilAsrEngine::Session> AprilAsrEngine::create_session(std::shared_ptr<AprilModel> model) {
+  auto session = std::make_unique<Session>();
+  session->owner = this;
+  session->mode = mode_;
+
+  AprilConfig cfg{};
+  cfg.handler = &AprilAsrEngine::handler_trampoline;
+  cfg.userdata = session.get();
+  switch (mode_) {
+  case Mode::AsyncRealtime:
+    cfg.flags = APRIL_CONFIG_FLAG_ASYNC_RT_BIT;
+    break;
+  case Mode::AsyncNoRealtime:
+    cfg.flags = APRIL_CONFIG_FLAG_ASYNC_NO_RT_BIT;
+    break;
+  case Mode::Synchronous:
+    cfg.flags = APRIL_CONFIG_FLAG_ZERO_BIT;
+    break;
+  }
+
+  // Asynchronous sessions start their decoding thread here.
+  const DefaultThreadPolicyScope default_policy;
+  session->handle = aas_create_session(model->handle(), cfg);
+  if (!session->handle) {
+    return nullptr;
+  }
+  session->model = std::move(model);
+  return session;
+}
+
+void AprilAsrEngine::free_session(std::unique_ptr<Session> session, bool keep_tail) {
+  if (!session) {
+    return;
+  }
+  bool flush = false;
+  if (keep_tail) {
+    std::scoped_lock lock(mutex_);
+    flush = partial_ && !partial_->empty();
+  }
+  // A draining session still delivers the final its flush produces.
+  session->state = flush ? SessionState::Draining : SessionState::Retired;
+  if (flush) {
+    aas_flush(session->handle);
+  }
+  aas_free(session->handle);
+}
+
+void AprilAsrEngine::reset_session_state() {
+  chunk_samples_ = sample_rate_ * chunk_ms_ / 1000;
+  chunk_buffer_.resize(chunk_samples_);
+  chunk_fill_ = 0;
+  overlap_.assign(sample_rate_ * kOverlapMs / 1000, 0);
+  overlap_pos_ = 0;
+  overlap_filled_ = 0;
+  session_fed_ = 0;
+  swap_fed_ = 0;
+  boundary_ = true;
+  final_end_samples_ = 0;
+  speedup_ = 0.0f;
+  std::scoped_lock lock(mutex_);
+  partial_.reset();
+  flush_time_.reset();
+  silence_hint_ = false;
+}
+
+void AprilAsrEngine::set_mode(Mode mode) {
+  if (mode == mode_) {
+    return;
+  }
+  mode_ = mode;
+  std::unique_ptr<Session> spare;
+  {
+    std::scoped_lock lock(swap_mutex_);
+    spare = std::move(spare_);
+  }
+  free_session(std::move(spare), false);
+}
 
-  model_ = aam_create_model(model_path_.string().c_str());
+void AprilAsrEngine::set_chunk_ms(unsigned ms) {
+  chunk_ms_ = ms;
+  chunk_samples_ = sample_rate_ * chunk_ms_ / 1000;
+  chunk_buffer_.resize(chunk_samples_);
+  chunk_fill_ = 0;
+}
+
+bool AprilAsrEngine::start(Mode mode) {
   if (!model_) {
     return false;
   }
-
-  sample_rate_ = aam_get_sample_rate(model_);
-  return true;
+  set_mode(mode);
+  if (session_ && session_->mode != mode) {
+    has_session_.store(false, std::memory_order_release);
+    free_session(std::move(session_), false);
+  }
+  return restart_session(false);
 }
 
-bool AprilAsrEngine::start() {
+bool AprilAsrEngine::restart_session(bool keep_tail) {
   if (!model_) {
     return false;
   }
+  if (session_ && session_->mode == mode_ && session_fed_ == 0 && chunk_fill_ == 0) {
+    return true;
+  }
+  if (keep_tail) {
+    feed_remainder();
+  }
+  free_session(std::move(session_), keep_tail);
+  {
+    std::scoped_lock lock(swap_mutex_);
+    session_ = std::move(spare_);
+  }
+  if (!session_) {
+    session_ = create_session(model_);
+  }
+  has_session_.store(session_ != nullptr, std::memory_order_release);
+  reset_session_state();
+  if (!session_) {
+    return false;
+  }
+  // The next restart should not wait for a session either.
+  if (keep_spare_) {
+    auto spare = create_session(model_);
+    std::scoped_lock lock(swap_mutex_);
+    spare_ = std::move(spare);
+  }
+  return true;
+}
 
-  AprilConfig cfg{};
-  cfg.handler = &AprilAsrEngine::handler_trampoline;
-  cfg.userdata = this;
-  cfg.flags = APRIL_CONFIG_FLAG_ASYNC_RT_BIT;
+void AprilAsrEngine::stop_session(bool keep_tail) {
+  if (keep_tail) {
+    feed_remainder();
+  }
+  // A staged session must not outlive the one it was meant to replace; the
+  // next restart then starts on the staged model.
+  complete_swap();
+  has_session_.store(false, std::memory_order_release);
+  free_session(std::move(session_), keep_tail);
+  reset_session_state();
+}
 
-  session_ = aas_create_session(model_, cfg);
-  return session_ != nullptr;
+void AprilAsrEngine::keep_spare(bool enabled) {
+  keep_spare_ = enabled;
+  std::unique_ptr<Session> spare;
+  {
+    std::scoped_lock lock(swap_mutex_);
+    if (!enabled) {
+      spare = std::move(spare_);
+    }
+  }
+  free_session(std::move(spare), false);
 }
 
 void AprilAsrEngine::stop() {
-  if (session_) {
-    aas_flush(session_);
-    aas_free(session_);
-    session_ = nullptr;
+  std::unique_ptr<Session> staged;
+  std::unique_ptr<Session> spare;
+  {
+    std::scoped_lock lock(swap_mutex_);
+    staged = std::move(staged_);
+    spare = std::move(spare_);
+    staged_model_.reset();
+    swap_pending_ = false;
   }
-  if (model_) {
-    aam_free(model_);
-    model_ = nullptr;
+  free_session(std::move(staged), false);
+  free_session(std::move(spare), false);
+  // Results are discarded below, so the session is not flushed first.
+  has_session_.store(false, std::memory_order_release);
+  free_session(std::move(session_), false);
+  reset_session_state();
+
+  std::scoped_lock lock(mutex_);
+  // Other engines may still hold the model; it is freed with the last one.
+  model_.reset();
+  pending_ = std::queue<TimedText>();
+}
+
+bool AprilAsrEngine::stage_model(std::shared_ptr<AprilModel> model) {
+  // session_ itself belongs to the feeding thread, which may be swapping it.
+  if (!has_session() || !model || model->sample_rate() != sample_rate_) {
+    return false;
+  }
+  auto session = create_session(model);
+  if (!session) {
+    return false;
+  }
+  std::unique_ptr<Session> replaced;
+  {
+    std::scoped_lock lock(swap_mutex_);
+    replaced = std::move(staged_);
+    staged_ = std::move(session);
+    staged_model_ = std::move(model);
+    if (!replaced) {
+      staged_at_ = std::chrono::steady_clock::now();
+    }
+    swap_pending_.store(true, std::memory_order_release);
+  }
+  // Never fed, but results may still be in flight; retire it like any other.
+  free_session(std::move(replaced), false);
+  return true;
+}
+
+bool AprilAsrEngine::swap_pending() const {
+  return swap_pending_.load(std::memory_order_acquire);
+}
+
+void AprilAsrEngine::complete_swap() {
+  if (swap_pending()) {
+    promote_staged(!boundary_.load(std::memory_order_acquire));
   }
+}
 
+AprilAsrEngine::SwapStats AprilAsrEngine::swap_stats() {
   std::scoped_lock lock(mutex_);
-  pending_ = std::queue<std::string>();
-  partial_.reset();
+  return swap_stats_;
+}
+
+void AprilAsrEngine::promote_staged(bool forced) {
+  std::unique_ptr<Session> old;
+  std::unique_ptr<Session> spare;
+  std::chrono::steady_clock::time_point staged_at;
+  {
+    std::scoped_lock lock(swap_mutex_);
+    swap_pending_ = false;
+    if (!staged_) {
+      return;
+    }
+    // The spare was built on the outgoing model; the next restart makes another.
+    spare = std::move(spare_);
+    old = std::move(session_);
+    session_ = std::move(staged_);
+    staged_at = staged_at_;
+    std::scoped_lock model_lock(mutex_);
+    model_ = std::move(staged_model_);
+  }
+
+  // At a boundary the old session's unfinished tail is dropped and replayed
+  // into the new one instead; forced, the old session finishes it itself.
+  size_t replay = 0;
+  if (old) {
+    old->state = forced ? SessionState::Draining : SessionState::Retired;
+    if (forced) {
+      aas_flush(old->handle);
+    } else {
+      const uint64_t final_end = std::min(final_end_samples_.load(), session_fed_);
+      replay = static_cast<size_t>(std::min<uint64_t>(session_fed_ - final_end, overlap_filled_));
+    }
+    aas_free(old->handle);
+  }
+  free_session(std::move(spare), false);
+
+  session_fed_ = 0;
+  swap_fed_ = 0;
+  final_end_samples_ = 0;
+  boundary_ = true;
+  if (replay > 0) {
+    replay_buffer_.resize(replay);
+    const size_t first = (overlap_pos_ + overlap_.size() - replay) % overlap_.size();
+    const size_t head = std::min(replay, overlap_.size() - first);
+    std::copy_n(overlap_.begin() + static_cast<std::ptrdiff_t>(first), head, replay_buffer_.begin());
+    std::copy_n(overlap_.begin(), replay - head, replay_buffer_.begin() + static_cast<std::ptrdiff_t>(head));
+    aas_feed_pcm16(session_->handle, replay_buffer_.data(), replay);
+    session_fed_ = replay;
+  }
+
+  const double wait_ms =
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - staged_at).count();
+  const double overlap_ms = static_cast<double>(replay) * 1000.0 / static_cast<double>(sample_rate_);
+  {
+    std::scoped_lock lock(mutex_);
+    partial_.reset();
+    flush_time_.reset();
+    ++swap_stats_.swaps;
+    if (forced) {
+      ++swap_stats_.forced;
+    }
+    swap_stats_.last_wait_ms = wait_ms;
+    swap_stats_.last_overlap_ms = overlap_ms;
+  }
+  std::fprintf(stdout, "[info] Session swapped %s after %.0f ms, replayed %.0f ms\n",
+               forced ? "mid-utterance" : "at a pause", wait_ms, overlap_ms);
+}
+
+void AprilAsrEngine::feed(short *samples, size_t count) {
+  if (swap_pending_.load(std::memory_order_acquire)) {
+    const bool timed_out = swap_fed_ >= sample_rate_ * kSwapTimeoutMs / 1000;
+    if (boundary_.load(std::memory_order_acquire) || timed_out) {
+      promote_staged(!boundary_.load(std::memory_order_acquire));
+    } else {
+      swap_fed_ += count;
+    }
+  }
+
+  aas_feed_pcm16(session_->handle, samples, count);
+  session_fed_ += count;
+  if (mode_ == Mode::AsyncRealtime) {
+    speedup_.store(aas_realtime_get_speedup(session_->handle), std::memory_order_relaxed);
+  }
+
+  if (!overlap_.empty()) {
+    const short *src = samples;
+    size_t left = std::min(count, overlap_.size());
+    src += count - left;
+    while (left > 0) {
+      const size_t n = std::min(left, overlap_.size() - overlap_pos_);
+      std::copy_n(src, n, overlap_.begin() + static_cast<std::ptrdiff_t>(overlap_pos_));
+      overlap_pos_ = (overlap_pos_ + n) % overlap_.size();
+      src += n;
+      left -= n;
+    }
+    overlap_filled_ = std::min(overlap_.size(), overlap_filled_ + count);
+  }
+}
+
+void AprilAsrEngine::coalesce(const short *samples, size_t count) {
+  // april-asr only reads the samples; the C API just lacks the const.
+  if (chunk_samples_ == 0) {
+    feed(const_cast<short *>(samples), count);
+    return;
+  }
+  while (count > 0) {
+    // Whole chunks straight from the input when nothing is waiting.
+    if (chunk_fill_ == 0 && count >= chunk_samples_) {
+      feed(const_cast<short *>(samples), chunk_samples_);
+      samples += chunk_samples_;
+      count -= chunk_samples_;
+      continue;
+    }
+    const size_t n = std::min(count, chunk_samples_ - chunk_fill_);
+    std::copy_n(samples, n, chunk_buffer_.begin() + static_cast<std::ptrdiff_t>(chunk_fill_));
+    chunk_fill_ += n;
+    samples += n;
+    count -= n;
+    if (chunk_fill_ == chunk_samples_) {
+      feed(chunk_buffer_.data(), chunk_samples_);
+      chunk_fill_ = 0;
+    }
+  }
+}
+
+void AprilAsrEngine::feed_remainder() {
+  if (session_ && chunk_fill_ > 0) {
+    feed(chunk_buffer_.data(), chunk_fill_);
+  }
+  chunk_fill_ = 0;
 }
 
-void AprilAsrEngine::push_audio(const std::vector<float> &samples) {
+void AprilAsrEngine::push_audio(std::span<const float> samples) {
   if (!session_ || samples.empty()) {
     return;
   }
 
   pcm16_buffer_.resize(samples.size());
-  for (std::size_t i = 0; i < samples.size(); ++i) {
-    float clamped = std::clamp(samples[i], -1.0f, 1.0f);
-    pcm16_buffer_[i] = static_cast<short>(std::lrintf(clamped * 32767.0f));
+  float_to_pcm16(samples.data(), pcm16_buffer_.data(), samples.size());
+
+  coalesce(pcm16_buffer_.data(), pcm16_buffer_.size());
+}
+
+void AprilAsrEngine::push_pcm16(std::span<const short> samples) {
+  if (!session_ || samples.empty()) {
+    return;
+  }
+  coalesce(samples.data(), samples.size());
+}
+
+bool AprilAsrEngine::flush() {
+  if (!session_) {
+    return false;
   }
+  // The pause ends in audio still waiting for a full chunk.
+  feed_remainder();
+  {
+    std::scoped_lock lock(mutex_);
+    if (!partial_ || partial_->empty()) {
+      return false;
+    }
+    flush_time_ = std::chrono::steady_clock::now();
+    ++flush_stats_.flushes;
+  }
+  aas_flush(session_->handle);
+  return true;
+}
 
-  aas_feed_pcm16(session_, pcm16_buffer_.data(), pcm16_buffer_.size());
+bool AprilAsrEngine::take_silence_hint() {
+  return silence_hint_.exchange(false, std::memory_order_relaxed);
+}
+
+AprilAsrEngine::FlushStats AprilAsrEngine::flush_stats() {
+  std::scoped_lock lock(mutex_);
+  return flush_stats_;
+}
+
+AprilAsrEngine::LoadStats AprilAsrEngine::load_stats() const {
+  LoadStats stats;
+  stats.speedup = speedup_.load(std::memory_order_relaxed);
+  stats.cant_keep_up = cant_keep_up_.load(std::memory_order_relaxed);
+  return stats;
 }
 
 std::optional<std::string> AprilAsrEngine::poll_text() {
+  if (auto timed = poll_timed_text()) {
+    return std::move(timed->text);
+  }
+  return std::nullopt;
+}
+
+std::optional<AprilAsrEngine::TimedText> AprilAsrEngine::poll_timed_text() {
   std::scoped_lock lock(mutex_);
   if (pending_.empty()) {
     return std::nullopt;
   }
-  auto out = pending_.front();
+  auto out = std::move(pending_.front());
   pending_.pop();
   return out;
 }
@@ -95,19 +466,28 @@ size_t AprilAsrEngine::sample_rate() const {
 
 void AprilAsrEngine::handler_trampoline(void *userdata, AprilResultType result, size_t count,
                                         const AprilToken *tokens) {
-  auto *self = static_cast<AprilAsrEngine *>(userdata);
-  if (!self) {
+  auto *session = static_cast<Session *>(userdata);
+  if (!session || !session->owner) {
     return;
   }
-  self->handle_result(result, count, tokens);
+  session->owner->handle_result(*session, result, count, tokens);
 }
 
-void AprilAsrEngine::handle_result(AprilResultType result, size_t count, const AprilToken *tokens) {
+void AprilAsrEngine::handle_result(Session &session, AprilResultType result, size_t count, const AprilToken *tokens) {
+  const SessionState state = session.state.load(std::memory_order_acquire);
+  if (state == SessionState::Retired || (state == SessionState::Draining && result != APRIL_RESULT_RECOGNITION_FINAL)) {
+    return;
+  }
+  const bool active = state == SessionState::Active;
+
   if (result == APRIL_RESULT_RECOGNITION_PARTIAL) {
     std::string text;
     for (size_t i = 0; i < count; ++i) {
       text.append(tokens[i].token ? tokens[i].token : "");
     }
+    if (!text.empty()) {
+      boundary_.store(false, std::memory_order_release);
+    }
     std::scoped_lock lock(mutex_);
     partial_ = std::move(text);
     return;
@@ -123,11 +503,33 @@ void AprilAsrEngine::handle_result(AprilResultType result, size_t count, const A
       text.append(tokens[i].token ? tokens[i].token : "");
     }
 
+    if (active) {
+      final_end_samples_.store(static_cast<uint64_t>(tokens[count - 1].time_ms) * sample_rate_ / 1000);
+      boundary_.store(true, std::memory_order_release);
+    }
     if (!text.empty()) {
       std::scoped_lock lock(mutex_);
-      pending_.push(std::move(text));
+      pending_.push(TimedText{std::move(text), tokens[0].time_ms, tokens[count - 1].time_ms});
       partial_.reset();
+      if (flush_time_) {
+        flush_stats_.last_latency_ms =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - *flush_time_).count();
+        flush_time_.reset();
+      }
     }
     return;
   }
+
+  if (result == APRIL_RESULT_ERROR_CANT_KEEP_UP && active) {
+    cant_keep_up_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  if (result == APRIL_RESULT_SILENCE && active) {
+    silence_hint_.store(true, std::memory_order_relaxed);
+    std::scoped_lock lock(mutex_);
+    if (!partial_ || partial_->empty()) {
+      boundary_.store(true, std::memory_order_release);
+    }
+  }
 }
@@ -0,0 +1,26 @@
+#include "april_model.h"
+
+#include <mutex>
+
+namespace {
+std::once_flag g_once;
+}
+
+std::shared_ptr<AprilModel> AprilModel::load(const std::filesystem::path &path) {
+  std::call_once(g_once, [] { aam_api_init(APRIL_VERSION); });
+  if (!std::filesystem::exists(path)) {
+    return nullptr;
+  }
+  AprilASRModel handle = aam_create_model(path.string().c_str());
+  if (!handle) {
+    return nullptr;
+  }
+  return std::shared_ptr<AprilModel>(new AprilModel(handle, path));
+}
+
+AprilModel::AprilModel(AprilASRModel handle, std::filesystem::path path)
+    : handle_(handle), sample_rate_(aam_get_sample_rate(handle)), path_(std::move(path)) {}
+
+AprilModel::~AprilModel() {
+  aam_free(handle_);
+}
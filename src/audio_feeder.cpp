@@ -0,0 +1,182 @@
+#include "audio_feeder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+
+#include "pcm_convert.h"
+
+namespace {
+// Enough to bridge a model reload while held. Outside a hold the fill is
+// kept within Options::max_latency_ms.
+constexpr size_t kRingSeconds = 30;
+// How long the backlog may stay over budget, e.g. draining what a hold left
+// behind, before it is cut.
+constexpr auto kLateGrace = std::chrono::seconds(3);
+constexpr size_t kChunkSamples = 4096;
+constexpr size_t kConvertBlock = 512;
+}  // namespace
+
+bool AudioFeeder::start(size_t sample_rate, Sink sink, const Options &options) {
+  if (sample_rate == 0 || !sink) {
+    return false;
+  }
+  if (running_) {
+    return true;
+  }
+  sink_ = std::move(sink);
+  options_ = options;
+  ring_.reset(sample_rate * kRingSeconds);
+  chunk_.assign(kChunkSamples, 0);
+  slice_samples_ = sample_rate * static_cast<size_t>(std::max(0, options_.slice_ms)) / 1000;
+  budget_samples_ = sample_rate * static_cast<size_t>(std::max(0, options_.max_latency_ms)) / 1000;
+  late_samples_ = 0;
+  late_events_ = 0;
+  if (options_.mix_aux) {
+    aux_ring_.reset(sample_rate * kRingSeconds);
+    aux_chunk_.assign(kChunkSamples, 0);
+    const size_t target = sample_rate * static_cast<size_t>(std::max(0, options_.aux_target_ms)) / 1000;
+    drift_.configure(sample_rate, target, kChunkSamples);
+  }
+  held_ = false;
+  policy_applied_ = false;
+  running_ = true;
+  worker_ = std::thread(&AudioFeeder::run_loop, this);
+  return true;
+}
+
+void AudioFeeder::stop() {
+  running_ = false;
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+}
+
+bool AudioFeeder::running() const {
+  return running_.load();
+}
+
+size_t AudioFeeder::free_space() const {
+  size_t limit = ring_.capacity();
+  if (budget_samples_ > 0 && !held_) {
+    limit = std::min(limit, budget_samples_);
+  }
+  const size_t fill = ring_.size();
+  return fill < limit ? limit - fill : 0;
+}
+
+void AudioFeeder::hold() {
+  held_ = true;
+  std::scoped_lock lock(sink_mutex_);
+}
+
+void AudioFeeder::resume() {
+  held_ = false;
+}
+
+void AudioFeeder::write(std::span<const float> samples) {
+  if (!running_ || samples.empty()) {
+    return;
+  }
+  write_float(ring_, samples);
+}
+
+void AudioFeeder::write_pcm16(std::span<const short> samples) {
+  if (!running_ || samples.empty()) {
+    return;
+  }
+  ring_.write(samples.data(), samples.size());
+}
+
+void AudioFeeder::write_aux(std::span<const float> samples) {
+  if (!running_ || !options_.mix_aux || samples.empty()) {
+    return;
+  }
+  write_float(aux_ring_, samples);
+}
+
+void AudioFeeder::write_aux_pcm16(std::span<const short> samples) {
+  if (!running_ || !options_.mix_aux || samples.empty()) {
+    return;
+  }
+  aux_ring_.write(samples.data(), samples.size());
+}
+
+void AudioFeeder::write_float(SpscRing<short> &ring, std::span<const float> samples) {
+  short scratch[kConvertBlock];
+  for (size_t done = 0; done < samples.size();) {
+    const size_t n = std::min(kConvertBlock, samples.size() - done);
+    float_to_pcm16(samples.data() + done, scratch, n);
+    ring.write(scratch, n);
+    done += n;
+  }
+}
+
+AudioFeeder::Stats AudioFeeder::stats() const {
+  Stats s;
+  s.fill = ring_.size();
+  s.capacity = ring_.capacity();
+  s.overflow_samples = ring_.overflow_samples();
+  s.overflow_events = ring_.overflow_events();
+  s.late_samples = late_samples_.load(std::memory_order_relaxed);
+  s.late_events = late_events_.load(std::memory_order_relaxed);
+  s.held = held_.load();
+  s.mixing = options_.mix_aux;
+  if (policy_applied_.load(std::memory_order_acquire)) {
+    s.thread_policy = policy_result_;
+  }
+  if (options_.mix_aux) {
+    s.aux_fill = aux_ring_.size();
+    s.aux_overflow_samples = aux_ring_.overflow_samples();
+    s.drift = drift_.stats();
+  }
+  return s;
+}
+
+void AudioFeeder::run_loop() {
+  policy_result_ = apply_thread_policy(options_.thread_policy);
+  policy_applied_.store(true, std::memory_order_release);
+  const auto idle_wait = std::chrono::milliseconds(std::max(1, options_.poll_ms));
+  // The part of chunk_ not yet delivered.
+  size_t offset = 0;
+  size_t pending = 0;
+  std::optional<std::chrono::steady_clock::time_point> late_since;
+  while (running_) {
+    if (held_) {
+      late_since.reset();
+    } else if (pending == 0 && options_.drop_late && budget_samples_ > 0) {
+      const size_t fill = ring_.size();
+      const auto now = std::chrono::steady_clock::now();
+      if (fill <= budget_samples_) {
+        late_since.reset();
+      } else if (!late_since) {
+        late_since = now;
+      } else if (now - *late_since >= kLateGrace) {
+        const size_t dropped = ring_.skip(fill - budget_samples_);
+        late_samples_.fetch_add(dropped, std::memory_order_relaxed);
+        late_events_.fetch_add(1, std::memory_order_relaxed);
+        late_since.reset();
+      }
+    }
+    std::unique_lock lock(sink_mutex_);
+    // Checked under the lock, and again before every slice, so hold() cannot
+    // return while audio is about to be delivered.
+    if (!held_ && pending == 0) {
+      pending = ring_.read(chunk_.data(), chunk_.size());
+      offset = 0;
+      if (pending > 0 && options_.mix_aux) {
+        drift_.process(aux_ring_, ring_.size(), std::span<short>(aux_chunk_.data(), pending));
+        mix_pcm16(chunk_.data(), options_.main_gain, aux_chunk_.data(), options_.aux_gain, chunk_.data(), pending);
+      }
+    }
+    if (held_ || pending == 0) {
+      lock.unlock();
+      std::this_thread::sleep_for(idle_wait);
+      continue;
+    }
+    const size_t n = slice_samples_ > 0 ? std::min(pending, slice_samples_) : pending;
+    sink_(std::span<const short>(chunk_.data() + offset, n));
+    offset += n;
+    pending -= n;
+  }
+}
@@ -2,13 +2,78 @@
 
 #ifdef HAVE_PIPEWIRE
 
+#include <algorithm>
+#include <thread>
+
 #include <pipewire/pipewire.h>
 #include <spa/param/audio/format-utils.h>
 #include <spa/param/audio/raw.h>
 #include <spa/param/props.h>
 
 namespace {
-const int kChannels = 2;
+// Upper bound on frames handed to the handler per call; larger quanta are split.
+const size_t kMaxBlockFrames = 8192;
+
+template <typename T, typename Handler>
+uint64_t flush_batch(std::vector<T> &batch, const Handler &handler) {
+  if (batch.empty()) {
+    return 0;
+  }
+  handler(std::span<const T>(batch));
+  batch.clear();
+  return 1;
+}
+
+// Collects samples until `target` frames are queued, then hands them off.
+// Never grows `batch` past the capacity reserved in start(). Returns the
+// number of handler calls made.
+template <typename T, typename Handler>
+uint64_t batch_and_deliver(std::vector<T> &batch, size_t target, std::span<const T> samples, const Handler &handler) {
+  uint64_t handoffs = 0;
+  if (target == 0 || batch.size() + samples.size() > batch.capacity()) {
+    handoffs += flush_batch(batch, handler);
+  }
+  if (target == 0 || samples.size() > batch.capacity()) {
+    handler(samples);
+    return handoffs + 1;
+  }
+  batch.insert(batch.end(), samples.begin(), samples.end());
+  if (batch.size() >= target) {
+    handoffs += flush_batch(batch, handler);
+  }
+  return handoffs;
+}
+
+ChannelPosition to_channel_position(uint32_t spa_channel) {
+  switch (spa_channel) {
+  case SPA_AUDIO_CHANNEL_MONO:
+    return ChannelPosition::Mono;
+  case SPA_AUDIO_CHANNEL_FL:
+    return ChannelPosition::FrontLeft;
+  case SPA_AUDIO_CHANNEL_FR:
+    return ChannelPosition::FrontRight;
+  case SPA_AUDIO_CHANNEL_FC:
+    return ChannelPosition::FrontCenter;
+  case SPA_AUDIO_CHANNEL_LFE:
+    return ChannelPosition::LowFrequency;
+  case SPA_AUDIO_CHANNEL_FLC:
+    return ChannelPosition::FrontLeftCenter;
+  case SPA_AUDIO_CHANNEL_FRC:
+    return ChannelPosition::FrontRightCenter;
+  case SPA_AUDIO_CHANNEL_SL:
+    return ChannelPosition::SideLeft;
+  case SPA_AUDIO_CHANNEL_SR:
+    return ChannelPosition::SideRight;
+  case SPA_AUDIO_CHANNEL_RL:
+    return ChannelPosition::RearLeft;
+  case SPA_AUDIO_CHANNEL_RR:
+    return ChannelPosition::RearRight;
+  case SPA_AUDIO_CHANNEL_RC:
+    return ChannelPosition::RearCenter;
+  default:
+    return ChannelPosition::Unknown;
+  }
+}
 }
 
 void AudioLinux::ensure_init() {
@@ -16,7 +81,7 @@ void AudioLinux::ensure_init() {
   std::call_once(once, [] { pw_init(nullptr, nullptr); });
 }
 
-bool AudioLinux::start(size_t sample_rate, int source, SampleHandler handler) {
+bool AudioLinux::start(size_t sample_rate, int source, SampleHandler handler, const CaptureOptions &options) {
   if (sample_rate == 0 || !handler) {
     return false;
   }
@@ -25,10 +90,39 @@ bool AudioLinux::start(size_t sample_rate, int source, SampleHandler handler) {
   }
 
   ensure_init();
+  // The graph's loop and data threads are started from here.
+  const DefaultThreadPolicyScope default_policy;
 
   handler_ = std::move(handler);
+  options_ = options;
   sample_rate_ = sample_rate;
   source_ = source;
+  for (Dsp &dsp : dsp_) {
+    dsp.channels = 0;
+    dsp.pcm16 = false;
+  }
+  dsp_active_ = 0;
+  dsp_in_use_ = -1;
+  format_changes_ = 0;
+  format_channels_ = 0;
+  format_direct_ = false;
+  // Size up front so the realtime callback never allocates.
+  mono_.assign(kMaxBlockFrames, 0.0f);
+  batch_frames_ = sample_rate_ * static_cast<size_t>(std::max(0, options_.batch_ms)) / 1000;
+  batch_.clear();
+  batch_pcm16_.clear();
+  if (batch_frames_ > 0) {
+    batch_.reserve(batch_frames_ + kMaxBlockFrames);
+    batch_pcm16_.reserve(batch_frames_ + kMaxBlockFrames);
+  }
+  started_ = std::chrono::steady_clock::now();
+  wakeups_ = 0;
+  handoffs_ = 0;
+  period_frames_ = 0;
+  period_rate_ = 0;
+  continuity_.reset();
+  continuity_.set_rate(0);
+  policy_applied_ = false;
 
   loop_ = pw_thread_loop_new("coollivecaptions-audio", nullptr);
   if (!loop_) {
@@ -65,9 +159,14 @@ bool AudioLinux::start(size_t sample_rate, int source, SampleHandler handler) {
   pw_properties_set(props, PW_KEY_MEDIA_CATEGORY, "Capture");
   pw_properties_set(props, PW_KEY_MEDIA_ROLE, "Communication");
   pw_properties_set(props, PW_KEY_STREAM_CAPTURE_SINK, capture_sink);
+  if (options_.latency_ms > 0) {
+    // A fraction of a second, so it holds whatever rate the graph runs at.
+    pw_properties_setf(props, PW_KEY_NODE_LATENCY, "%d/1000", options_.latency_ms);
+  }
 
   static const pw_stream_events stream_events = {
       .version = PW_VERSION_STREAM_EVENTS,
+      .param_changed = &AudioLinux::on_param_changed,
       .process = &AudioLinux::on_process,
   };
 
@@ -88,23 +187,38 @@ bool AudioLinux::start(size_t sample_rate, int source, SampleHandler handler) {
 
   pw_core_disconnect(core);
 
+  uint8_t buffer[1024];
+  spa_pod_builder b = SPA_POD_BUILDER_INIT(buffer, sizeof(buffer));
+  const spa_pod *params[2];
+  uint32_t n_params = 0;
+
+  if (options_.pcm16_handler) {
+    // Preferred when asked for: mono PCM16 at the model rate, which goes to
+    // the engine with no float round-trip. The graph's adapter can convert
+    // any source to it, so it does the downmix and resampling in place of
+    // ours, and the native format below is only a fallback.
+    spa_audio_info_raw s16{};
+    s16.format = SPA_AUDIO_FORMAT_S16;
+    s16.rate = static_cast<uint32_t>(sample_rate_);
+    s16.channels = 1;
+    s16.position[0] = SPA_AUDIO_CHANNEL_MONO;
+    params[n_params++] = spa_format_audio_raw_build(&b, SPA_PARAM_EnumFormat, &s16);
+  }
+
   spa_audio_info_raw info{};
   info.format = SPA_AUDIO_FORMAT_F32;
-  info.rate = static_cast<uint32_t>(sample_rate_);
-  info.channels = kChannels;
-  info.position[0] = SPA_AUDIO_CHANNEL_FL;
-  info.position[1] = SPA_AUDIO_CHANNEL_FR;
-
-  uint8_t buffer[256];
-  spa_pod_builder b = SPA_POD_BUILDER_INIT(buffer, sizeof(buffer));
-  const spa_pod *params[] = {spa_format_audio_raw_build(&b, SPA_PARAM_EnumFormat, &info)};
+  // Leave rate and channel count open so we capture the source's native
+  // format; downmixing and resampling happen here instead of in the graph.
+  info.rate = 0;
+  info.channels = 0;
+  params[n_params++] = spa_format_audio_raw_build(&b, SPA_PARAM_EnumFormat, &info);
 
   running_ = true;
   pw_thread_loop_lock(loop_);
   pw_thread_loop_start(loop_);
   int res = pw_stream_connect(stream_, PW_DIRECTION_INPUT, PW_ID_ANY,
                               static_cast<pw_stream_flags>(PW_STREAM_FLAG_AUTOCONNECT | PW_STREAM_FLAG_MAP_BUFFERS | PW_STREAM_FLAG_RT_PROCESS),
-                              params, 1);
+                              params, n_params);
   pw_thread_loop_unlock(loop_);
 
   if (res < 0) {
@@ -143,70 +257,205 @@ void AudioLinux::stop() {
   }
 }
 
+void AudioLinux::on_param_changed(void *data, uint32_t id, const spa_pod *param) {
+  auto *self = static_cast<AudioLinux *>(data);
+  if (!self || !param || id != SPA_PARAM_Format) {
+    return;
+  }
+  uint32_t media_type = 0;
+  uint32_t media_subtype = 0;
+  if (spa_format_parse(param, &media_type, &media_subtype) < 0 || media_type != SPA_MEDIA_TYPE_audio ||
+      media_subtype != SPA_MEDIA_SUBTYPE_raw) {
+    return;
+  }
+  spa_audio_info_raw info{};
+  if (spa_format_audio_raw_parse(param, &info) < 0 || info.channels == 0 ||
+      info.channels > Downmixer::kMaxChannels || info.rate == 0) {
+    return;
+  }
+
+  // Build into the slot that is not published, once the data thread has
+  // let go of it.
+  const int slot = 1 - self->dsp_active_.load();
+  while (self->dsp_in_use_.load() == slot) {
+    std::this_thread::yield();
+  }
+  Dsp &dsp = self->dsp_[slot];
+  dsp.channels = 0;
+  dsp.pcm16 = false;
+  if (info.format == SPA_AUDIO_FORMAT_S16 && info.channels == 1 && info.rate == self->sample_rate_ &&
+      self->options_.pcm16_handler) {
+    dsp.pcm16 = true;
+    dsp.channels = 1;
+  } else if (info.format == SPA_AUDIO_FORMAT_F32) {
+    std::vector<ChannelPosition> layout;
+    if (!(info.flags & SPA_AUDIO_FLAG_UNPOSITIONED)) {
+      layout.reserve(info.channels);
+      for (uint32_t ch = 0; ch < info.channels; ++ch) {
+        layout.push_back(to_channel_position(info.position[ch]));
+      }
+    }
+    if (dsp.downmix.configure(info.channels, layout) &&
+        dsp.resampler.configure(info.rate, self->sample_rate_, self->options_.resample_quality)) {
+      dsp.resampler.reserve(kMaxBlockFrames);
+      dsp.resampled.reserve(kMaxBlockFrames * self->sample_rate_ / info.rate + 2);
+      dsp.channels = info.channels;
+    }
+  }
+  self->dsp_active_.store(slot);
+
+  self->period_rate_ = info.rate;
+  self->continuity_.set_rate(info.rate);
+  self->format_channels_ = dsp.channels;
+  self->format_direct_ = dsp.pcm16;
+  self->format_changes_.fetch_add(1);
+}
+
 void AudioLinux::on_process(void *data) {
   auto *self = static_cast<AudioLinux *>(data);
   if (!self || !self->stream_ || !self->handler_) {
     return;
   }
+  if (!self->policy_applied_.load(std::memory_order_relaxed)) {
+    // The graph owns this thread, so it can only be adjusted from inside it.
+    self->policy_result_ = apply_thread_policy(self->options_.thread_policy);
+    self->policy_applied_.store(true, std::memory_order_release);
+  }
+
+  self->process_period(*self->acquire_dsp());
+  self->dsp_in_use_.store(-1);
+}
 
-  pw_buffer *buffer = pw_stream_dequeue_buffer(self->stream_);
+void AudioLinux::process_period(Dsp &dsp) {
+  pw_buffer *buffer = pw_stream_dequeue_buffer(stream_);
   if (!buffer) {
     return;
   }
   spa_buffer *b = buffer->buffer;
   if (!b || b->n_datas == 0) {
-    pw_stream_queue_buffer(self->stream_, buffer);
+    pw_stream_queue_buffer(stream_, buffer);
     return;
   }
 
   spa_data *d = b->datas;
   if (!d->data) {
-    pw_stream_queue_buffer(self->stream_, buffer);
+    pw_stream_queue_buffer(stream_, buffer);
     return;
   }
 
+  const uint32_t channels = dsp.channels;
+  const bool pcm16 = dsp.pcm16;
   const spa_chunk *c = d->chunk;
   uint32_t offset = c ? c->offset : 0;
   uint32_t size = c ? c->size : d->maxsize;
-  uint32_t stride = c && c->stride ? c->stride : static_cast<uint32_t>(sizeof(float) * kChannels);
-  if (stride == 0 || size == 0) {
-    pw_stream_queue_buffer(self->stream_, buffer);
+  const uint32_t sample_size = static_cast<uint32_t>(pcm16 ? sizeof(short) : sizeof(float));
+  const uint32_t stride = sample_size * channels;
+  // A stride that disagrees with the negotiated format means we cannot
+  // interpret the buffer; drop it rather than misread channels.
+  if (stride == 0 || size == 0 || (c && c->stride != 0 && static_cast<uint32_t>(c->stride) != stride)) {
+    pw_stream_queue_buffer(stream_, buffer);
     return;
   }
 
   uint8_t *data_ptr = static_cast<uint8_t *>(d->data) + offset;
   uint32_t frames = size / stride;
   if (frames == 0) {
-    pw_stream_queue_buffer(self->stream_, buffer);
+    pw_stream_queue_buffer(stream_, buffer);
+    return;
+  }
+  wakeups_.fetch_add(1, std::memory_order_relaxed);
+  period_frames_.store(frames, std::memory_order_relaxed);
+  continuity_.on_period(frames, c && (c->flags & SPA_CHUNK_FLAG_CORRUPTED));
+
+  if (pcm16) {
+    deliver_pcm16(std::span<const short>(reinterpret_cast<const short *>(data_ptr), frames));
+    pw_stream_queue_buffer(stream_, buffer);
     return;
   }
 
   const float *interleaved = reinterpret_cast<const float *>(data_ptr);
-  self->mono_.resize(frames);
-  for (uint32_t i = 0; i < frames; ++i) {
-    float l = interleaved[i * kChannels + 0];
-    float r = interleaved[i * kChannels + 1];
-    self->mono_[i] = 0.5f * (l + r);
+  for (uint32_t done = 0; done < frames;) {
+    const uint32_t block = static_cast<uint32_t>(std::min<size_t>(frames - done, kMaxBlockFrames));
+    dsp.downmix.process(interleaved + static_cast<size_t>(done) * channels, block, mono_.data());
+    std::span<const float> mono(mono_.data(), block);
+    if (dsp.resampler.passthrough()) {
+      deliver(mono);
+    } else {
+      dsp.resampler.process(mono, dsp.resampled);
+      if (!dsp.resampled.empty()) {
+        deliver(dsp.resampled);
+      }
+    }
+    done += block;
   }
 
-  if (!self->mono_.empty()) {
-    self->handler_(self->mono_);
+  pw_stream_queue_buffer(stream_, buffer);
+}
+
+AudioLinux::Dsp *AudioLinux::acquire_dsp() {
+  // Claims the published slot. Rechecking after the claim closes the window
+  // where on_param_changed() publishes the other slot and starts rebuilding
+  // this one before seeing the claim; both sides use sequentially consistent
+  // order for this.
+  int slot = dsp_active_.load();
+  while (true) {
+    dsp_in_use_.store(slot);
+    const int active = dsp_active_.load();
+    if (active == slot) {
+      return &dsp_[slot];
+    }
+    slot = active;
   }
+}
+
+void AudioLinux::deliver(std::span<const float> samples) {
+  // Anything batched in the other format came first.
+  uint64_t handoffs = flush_batch(batch_pcm16_, options_.pcm16_handler);
+  handoffs += batch_and_deliver(batch_, batch_frames_, samples, handler_);
+  handoffs_.fetch_add(handoffs, std::memory_order_relaxed);
+}
 
-  pw_stream_queue_buffer(self->stream_, buffer);
+void AudioLinux::deliver_pcm16(std::span<const short> samples) {
+  uint64_t handoffs = flush_batch(batch_, handler_);
+  handoffs += batch_and_deliver(batch_pcm16_, batch_frames_, samples, options_.pcm16_handler);
+  handoffs_.fetch_add(handoffs, std::memory_order_relaxed);
+}
+
+CaptureStats AudioLinux::stats() const {
+  CaptureStats s;
+  const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_).count();
+  if (running_ && elapsed > 0.0) {
+    s.wakeups_per_sec = static_cast<double>(wakeups_.load(std::memory_order_relaxed)) / elapsed;
+    s.handoffs_per_sec = static_cast<double>(handoffs_.load(std::memory_order_relaxed)) / elapsed;
+  }
+  s.period_frames = period_frames_.load(std::memory_order_relaxed);
+  s.period_rate = period_rate_.load(std::memory_order_relaxed);
+  s.format_changes = format_changes_.load();
+  s.format_channels = format_channels_.load();
+  s.format_direct = format_direct_.load();
+  s.continuity = continuity_.counters();
+  if (policy_applied_.load(std::memory_order_acquire)) {
+    s.thread_policy = policy_result_;
+  }
+  return s;
 }
 
 #else
 
-bool AudioLinux::start(size_t sample_rate, int source, SampleHandler handler) {
+bool AudioLinux::start(size_t sample_rate, int source, SampleHandler handler, const CaptureOptions &options) {
   (void)sample_rate;
   (void)source;
   (void)handler;
+  (void)options;
   return false;
 }
 
 void AudioLinux::stop() {}
 
+CaptureStats AudioLinux::stats() const {
+  return {};
+}
+
 void AudioLinux::ensure_init() {}
 void AudioLinux::on_process(void *) {}
 
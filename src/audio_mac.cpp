@@ -1,9 +1,14 @@
 #include "audio_mac.h"
 
-bool AudioMac::start(size_t sample_rate, int /*source*/, SampleHandler handler) {
+bool AudioMac::start(size_t sample_rate, int /*source*/, SampleHandler handler, const CaptureOptions &options) {
   (void)sample_rate;
   (void)handler;
+  (void)options;
   return false;
 }
 
 void AudioMac::stop() {}
+
+CaptureStats AudioMac::stats() const {
+  return {};
+}
@@ -0,0 +1,333 @@
+#include "audio_pipe.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+constexpr size_t kReadBytes = 64 * 1024;
+constexpr size_t kBlockFrames = 4096;
+constexpr int kPollMs = 100;
+// After a short read, let the pipe fill up before reading again so a
+// realtime-paced producer costs tens of reads per second, not thousands.
+constexpr auto kCoalesceWait = std::chrono::milliseconds(10);
+constexpr auto kSpaceWait = std::chrono::milliseconds(5);
+
+#if defined(_WIN32)
+class PipeReader {
+public:
+  bool open(const std::string &path) {
+    if (path == "-") {
+      handle_ = GetStdHandle(STD_INPUT_HANDLE);
+    } else {
+      handle_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0,
+                            nullptr);
+      owned_ = true;
+    }
+    return handle_ != nullptr && handle_ != INVALID_HANDLE_VALUE;
+  }
+
+  // > 0 bytes read, 0 nothing available yet, -1 end of stream or error.
+  long read(uint8_t *dst, size_t capacity) {
+    // Peek first so stop() is never stuck behind a blocking read. Regular
+    // files redirected to stdin fail the peek and are read directly.
+    DWORD avail = 0;
+    if (PeekNamedPipe(handle_, nullptr, 0, nullptr, &avail, nullptr)) {
+      if (avail == 0) {
+        Sleep(kPollMs / 10);
+        return 0;
+      }
+      capacity = std::min<size_t>(capacity, avail);
+    } else if (GetLastError() == ERROR_BROKEN_PIPE) {
+      return -1;
+    }
+    DWORD got = 0;
+    if (!ReadFile(handle_, dst, static_cast<DWORD>(capacity), &got, nullptr) || got == 0) {
+      return -1;
+    }
+    return static_cast<long>(got);
+  }
+
+  void close() {
+    if (owned_ && handle_ != INVALID_HANDLE_VALUE) {
+      CloseHandle(handle_);
+    }
+    handle_ = INVALID_HANDLE_VALUE;
+  }
+
+private:
+  HANDLE handle_ = INVALID_HANDLE_VALUE;
+  bool owned_ = false;
+};
+#else
+class PipeReader {
+public:
+  bool open(const std::string &path) {
+    if (path == "-") {
+      fd_ = STDIN_FILENO;
+      return true;
+    }
+    // Non-blocking so opening a FIFO does not wait for a writer; reads block
+    // (behind poll) once it is open.
+    fd_ = ::open(path.c_str(), O_RDONLY | O_NONBLOCK);
+    if (fd_ < 0) {
+      return false;
+    }
+    owned_ = true;
+    struct stat st {};
+    fifo_ = fstat(fd_, &st) == 0 && S_ISFIFO(st.st_mode);
+    const int flags = fcntl(fd_, F_GETFL);
+    if (flags >= 0) {
+      fcntl(fd_, F_SETFL, flags & ~O_NONBLOCK);
+    }
+    return true;
+  }
+
+  // > 0 bytes read, 0 nothing available yet, -1 end of stream or error.
+  long read(uint8_t *dst, size_t capacity) {
+    pollfd pfd{fd_, POLLIN, 0};
+    const int ready = ::poll(&pfd, 1, kPollMs);
+    if (ready == 0) {
+      return 0;
+    }
+    if (ready < 0) {
+      return errno == EINTR ? 0 : -1;
+    }
+    const ssize_t n = ::read(fd_, dst, capacity);
+    if (n > 0) {
+      seen_data_ = true;
+      return static_cast<long>(n);
+    }
+    if (n < 0) {
+      return errno == EINTR || errno == EAGAIN ? 0 : -1;
+    }
+    // A FIFO reads as closed until its first writer connects.
+    if (fifo_ && !seen_data_) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(kPollMs / 2));
+      return 0;
+    }
+    return -1;
+  }
+
+  void close() {
+    if (owned_ && fd_ >= 0) {
+      ::close(fd_);
+    }
+    fd_ = -1;
+  }
+
+private:
+  int fd_ = -1;
+  bool owned_ = false;
+  bool fifo_ = false;
+  bool seen_data_ = false;
+};
+#endif
+}  // namespace
+
+bool AudioPipe::parse_format(std::string_view text, Format &out) {
+  if (text == "s16le" || text == "s16") {
+    out = Format::S16LE;
+    return true;
+  }
+  if (text == "f32le" || text == "f32") {
+    out = Format::F32LE;
+    return true;
+  }
+  return false;
+}
+
+bool AudioPipe::start(size_t sample_rate, const Config &config, SampleHandler handler, const CaptureOptions &options) {
+  if (sample_rate == 0 || !handler || config.rate == 0 || config.channels == 0 ||
+      config.channels > Downmixer::kMaxChannels) {
+    return false;
+  }
+  if (running_) {
+    return true;
+  }
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+
+  config_ = config;
+  handler_ = std::move(handler);
+  options_ = options;
+  sample_rate_ = sample_rate;
+  direct_pcm16_ = config_.format == Format::S16LE && config_.channels == 1 && config_.rate == sample_rate_ &&
+                  options_.pcm16_handler;
+  if (!downmix_.configure(config_.channels) ||
+      !resampler_.configure(config_.rate, sample_rate_, options_.resample_quality)) {
+    std::fprintf(stderr, "[error] Pipe input cannot convert %u Hz x %u ch to %zu Hz\n", config_.rate, config_.channels,
+                 sample_rate_);
+    return false;
+  }
+  resampler_.reserve(kBlockFrames);
+
+  raw_.assign(kReadBytes, 0);
+  interleaved_.assign(kBlockFrames * config_.channels, 0.0f);
+  pcm16_.assign(kBlockFrames * config_.channels, 0);
+  mono_.assign(kBlockFrames, 0.0f);
+  resampled_.reserve(kBlockFrames * sample_rate_ / config_.rate + 2);
+
+  started_ = std::chrono::steady_clock::now();
+  reads_ = 0;
+  handoffs_ = 0;
+  frames_ = 0;
+  read_frames_ = 0;
+  policy_applied_ = false;
+  finished_ = false;
+  running_ = true;
+  worker_ = std::thread(&AudioPipe::run_loop, this);
+  return true;
+}
+
+void AudioPipe::stop() {
+  running_ = false;
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+}
+
+bool AudioPipe::running() const {
+  return running_.load();
+}
+
+bool AudioPipe::finished() const {
+  return finished_.load();
+}
+
+CaptureStats AudioPipe::stats() const {
+  CaptureStats s;
+  const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_).count();
+  if (running_ && elapsed > 0.0) {
+    s.wakeups_per_sec = static_cast<double>(reads_.load(std::memory_order_relaxed)) / elapsed;
+    s.handoffs_per_sec = static_cast<double>(handoffs_.load(std::memory_order_relaxed)) / elapsed;
+  }
+  s.period_frames = read_frames_.load(std::memory_order_relaxed);
+  s.period_rate = config_.rate;
+  // A pipe has no clock to check against; only volume is tracked.
+  s.continuity.frames = frames_.load(std::memory_order_relaxed);
+  s.continuity.periods = reads_.load(std::memory_order_relaxed);
+  s.continuity.rate = config_.rate;
+  if (policy_applied_.load(std::memory_order_acquire)) {
+    s.thread_policy = policy_result_;
+  }
+  return s;
+}
+
+void AudioPipe::run_loop() {
+  policy_result_ = apply_thread_policy(options_.thread_policy);
+  policy_applied_.store(true, std::memory_order_release);
+
+  PipeReader reader;
+  if (!reader.open(config_.path)) {
+    std::fprintf(stderr, "[error] Pipe input: cannot open %s\n", config_.path.c_str());
+    finished_ = true;
+    running_ = false;
+    return;
+  }
+  std::fprintf(stdout, "[info] Pipe input opened (%s, %s, %u Hz, %u ch -> %zu Hz%s)\n",
+               config_.path == "-" ? "stdin" : config_.path.c_str(), config_.format == Format::S16LE ? "s16le" : "f32le",
+               config_.rate, config_.channels, sample_rate_, direct_pcm16_ ? ", direct" : "");
+
+  const size_t sample_bytes = config_.format == Format::S16LE ? sizeof(short) : sizeof(float);
+  const size_t frame_bytes = sample_bytes * config_.channels;
+  size_t held = 0;
+  while (running_) {
+    const long n = reader.read(raw_.data() + held, raw_.size() - held);
+    if (n < 0) {
+      finished_ = true;
+      std::fprintf(stdout, "[info] Pipe input ended\n");
+      break;
+    }
+    if (n == 0) {
+      continue;
+    }
+    reads_.fetch_add(1, std::memory_order_relaxed);
+    held += static_cast<size_t>(n);
+    const size_t frames = held / frame_bytes;
+    read_frames_.store(static_cast<uint32_t>(frames), std::memory_order_relaxed);
+    frames_.fetch_add(frames, std::memory_order_relaxed);
+
+    for (size_t done = 0; done < frames && running_;) {
+      const size_t block = std::min(kBlockFrames, frames - done);
+      const uint8_t *src = raw_.data() + done * frame_bytes;
+      const size_t samples = block * config_.channels;
+      if (config_.format == Format::S16LE) {
+        std::memcpy(pcm16_.data(), src, samples * sizeof(short));
+        if (direct_pcm16_) {
+          deliver_pcm16(std::span<const short>(pcm16_.data(), block));
+          done += block;
+          continue;
+        }
+        constexpr float scale = 1.0f / 32768.0f;
+        for (size_t i = 0; i < samples; ++i) {
+          interleaved_[i] = static_cast<float>(pcm16_[i]) * scale;
+        }
+      } else {
+        std::memcpy(interleaved_.data(), src, samples * sizeof(float));
+      }
+      downmix_.process(interleaved_.data(), block, mono_.data());
+      std::span<const float> mono(mono_.data(), block);
+      if (resampler_.passthrough()) {
+        deliver(mono);
+      } else {
+        resampler_.process(mono, resampled_);
+        deliver(resampled_);
+      }
+      done += block;
+    }
+
+    // Keep a trailing partial frame for the next read.
+    const size_t used = frames * frame_bytes;
+    std::memmove(raw_.data(), raw_.data() + used, held - used);
+    held -= used;
+    if (static_cast<size_t>(n) < raw_.size() / 4) {
+      std::this_thread::sleep_for(kCoalesceWait);
+    }
+  }
+  reader.close();
+  running_ = false;
+}
+
+bool AudioPipe::wait_for_space(size_t samples) {
+  if (!config_.free_space) {
+    return true;
+  }
+  while (running_) {
+    if (config_.free_space() >= samples) {
+      return true;
+    }
+    std::this_thread::sleep_for(kSpaceWait);
+  }
+  return false;
+}
+
+void AudioPipe::deliver(std::span<const float> samples) {
+  if (samples.empty() || !wait_for_space(samples.size())) {
+    return;
+  }
+  handler_(samples);
+  handoffs_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AudioPipe::deliver_pcm16(std::span<const short> samples) {
+  if (samples.empty() || !wait_for_space(samples.size())) {
+    return;
+  }
+  options_.pcm16_handler(samples);
+  handoffs_.fetch_add(1, std::memory_order_relaxed);
+}
@@ -1,10 +1,10 @@
 #include "audio_win.h"
 
 #include <algorithm>
-#include <cmath>
 #include <cstdint>
 #include <cstdio>
 #include <memory>
+#include <span>
 #include <vector>
 
 #include <audioclient.h>
@@ -13,15 +13,48 @@
 #include <mmdeviceapi.h>
 #include <wrl/client.h>
 
+#include "downmix.h"
+#include "resampler.h"
+
 using Microsoft::WRL::ComPtr;
 
 namespace {
 void log_hr(const char *stage, HRESULT hr) {
   std::fprintf(stderr, "[error] WASAPI %s failed: 0x%08lx\n", stage, static_cast<unsigned long>(hr));
 }
+
+// Channels in a WAVEFORMATEXTENSIBLE stream appear in ascending speaker-bit order.
+std::vector<ChannelPosition> layout_from_mask(DWORD mask, WORD channels) {
+  static const struct {
+    DWORD bit;
+    ChannelPosition pos;
+  } kSpeakers[] = {
+      {SPEAKER_FRONT_LEFT, ChannelPosition::FrontLeft},
+      {SPEAKER_FRONT_RIGHT, ChannelPosition::FrontRight},
+      {SPEAKER_FRONT_CENTER, ChannelPosition::FrontCenter},
+      {SPEAKER_LOW_FREQUENCY, ChannelPosition::LowFrequency},
+      {SPEAKER_BACK_LEFT, ChannelPosition::RearLeft},
+      {SPEAKER_BACK_RIGHT, ChannelPosition::RearRight},
+      {SPEAKER_FRONT_LEFT_OF_CENTER, ChannelPosition::FrontLeftCenter},
+      {SPEAKER_FRONT_RIGHT_OF_CENTER, ChannelPosition::FrontRightCenter},
+      {SPEAKER_BACK_CENTER, ChannelPosition::RearCenter},
+      {SPEAKER_SIDE_LEFT, ChannelPosition::SideLeft},
+      {SPEAKER_SIDE_RIGHT, ChannelPosition::SideRight},
+  };
+  std::vector<ChannelPosition> layout;
+  for (const auto &speaker : kSpeakers) {
+    if (mask & speaker.bit) {
+      layout.push_back(speaker.pos);
+    }
+  }
+  if (layout.size() != channels) {
+    layout.clear();
+  }
+  return layout;
+}
 }
 
-bool AudioWin::start(size_t sample_rate, Source source, SampleHandler handler) {
+bool AudioWin::start(size_t sample_rate, Source source, SampleHandler handler, const CaptureOptions &options) {
   if (sample_rate == 0) {
     return false;
   }
@@ -31,6 +64,15 @@ bool AudioWin::start(size_t sample_rate, Source source, SampleHandler handler) {
   sample_rate_ = sample_rate;
   source_ = source;
   handler_ = std::move(handler);
+  options_ = options;
+  started_ = std::chrono::steady_clock::now();
+  wakeups_ = 0;
+  handoffs_ = 0;
+  period_frames_ = 0;
+  period_rate_ = 0;
+  continuity_.reset();
+  continuity_.set_intermittent(source == Source::Loopback);
+  policy_applied_ = false;
   running_ = true;
   worker_ = std::thread(&AudioWin::run_loop, this);
   return true;
@@ -58,7 +100,26 @@ bool AudioWin::running() const {
   return running_.load();
 }
 
+CaptureStats AudioWin::stats() const {
+  CaptureStats s;
+  const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_).count();
+  if (running_ && elapsed > 0.0) {
+    s.wakeups_per_sec = static_cast<double>(wakeups_.load(std::memory_order_relaxed)) / elapsed;
+    s.handoffs_per_sec = static_cast<double>(handoffs_.load(std::memory_order_relaxed)) / elapsed;
+  }
+  s.period_frames = period_frames_.load(std::memory_order_relaxed);
+  s.period_rate = period_rate_.load(std::memory_order_relaxed);
+  s.continuity = continuity_.counters();
+  if (policy_applied_.load(std::memory_order_acquire)) {
+    s.thread_policy = policy_result_;
+  }
+  return s;
+}
+
 void AudioWin::run_loop() {
+  policy_result_ = apply_thread_policy(options_.thread_policy);
+  policy_applied_.store(true, std::memory_order_release);
+
   HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
   if (FAILED(hr)) {
     log_hr("CoInitializeEx", hr);
@@ -119,7 +180,12 @@ void AudioWin::run_loop() {
                         mix->wBitsPerSample == 16;
   const WORD channels = mix->nChannels;
   const UINT32 mix_rate = mix->nSamplesPerSec;
-  if (channels == 0) {
+  std::vector<ChannelPosition> layout;
+  if (mix->wFormatTag == WAVE_FORMAT_EXTENSIBLE) {
+    layout = layout_from_mask(reinterpret_cast<WAVEFORMATEXTENSIBLE *>(mix.get())->dwChannelMask, channels);
+  }
+  Downmixer downmix;
+  if (channels == 0 || !downmix.configure(channels, layout)) {
     running_ = false;
     return;
   }
@@ -171,17 +237,37 @@ void AudioWin::run_loop() {
   std::fprintf(stdout, "[info] WASAPI started (%s, mix %u Hz, %u ch -> %zu Hz)\n", source_label,
                mix_rate, static_cast<unsigned int>(channels), sample_rate_);
 
-  const double step = static_cast<double>(mix_rate) / static_cast<double>(sample_rate_);
+  Resampler resampler;
+  if (!resampler.configure(mix_rate, sample_rate_, options_.resample_quality)) {
+    std::fprintf(stderr, "[error] WASAPI cannot resample %u Hz to %zu Hz\n", mix_rate, sample_rate_);
+    client->Stop();
+    running_ = false;
+    return;
+  }
 
+  // Scratch buffers are sized once from the endpoint buffer and reused for
+  // every packet so steady-state capture does not allocate.
+  UINT32 buffer_frames = 0;
+  if (FAILED(client->GetBufferSize(&buffer_frames)) || buffer_frames == 0) {
+    buffer_frames = mix_rate / 10;
+  }
   std::vector<float> buffer;
   std::vector<float> mono;
+  std::vector<float> output;
+  buffer.reserve(static_cast<size_t>(buffer_frames) * channels);
+  mono.reserve(buffer_frames);
+  output.reserve(static_cast<size_t>(buffer_frames) * sample_rate_ / mix_rate + 2);
+  resampler.reserve(buffer_frames);
   bool logged_first_packet = false;
+  period_rate_ = mix_rate;
+  continuity_.set_rate(mix_rate);
 
   while (running_) {
     DWORD wait = WaitForSingleObject(capture_event_, 200);
     if (wait != WAIT_OBJECT_0) {
       continue;
     }
+    wakeups_.fetch_add(1, std::memory_order_relaxed);
 
     UINT32 packet = 0;
     if (FAILED(capture->GetNextPacketSize(&packet))) {
@@ -194,53 +280,41 @@ void AudioWin::run_loop() {
     BYTE *data = nullptr;
     UINT32 frames = 0;
     DWORD capture_flags = 0;
-    hr = capture->GetBuffer(&data, &frames, &capture_flags, nullptr, nullptr);
+    UINT64 device_position = 0;
+    hr = capture->GetBuffer(&data, &frames, &capture_flags, &device_position, nullptr);
     if (FAILED(hr)) {
       break;
     }
+    continuity_.on_period_at(frames, device_position, (capture_flags & AUDCLNT_BUFFERFLAGS_DATA_DISCONTINUITY) != 0);
 
+    period_frames_.store(frames, std::memory_order_relaxed);
     const size_t samples = static_cast<size_t>(frames) * channels;
-    buffer.resize(samples);
-
     const bool silent = (capture_flags & AUDCLNT_BUFFERFLAGS_SILENT) || data == nullptr;
-    if (silent) {
-      std::fill(buffer.begin(), buffer.end(), 0.0f);
-    } else if (is_float) {
-      const float *src = reinterpret_cast<const float *>(data);
-      std::copy(src, src + samples, buffer.begin());
-    } else if (is_pcm16 || is_ext16) {
-      const int16_t *src = reinterpret_cast<const int16_t *>(data);
-      constexpr float scale = 1.0f / 32768.0f;
-      for (size_t i = 0; i < samples; ++i) {
-        buffer[i] = static_cast<float>(src[i]) * scale;
-      }
+    const float *interleaved = nullptr;
+    if (!silent && is_float) {
+      // Float mix format: downmix straight from the endpoint buffer.
+      interleaved = reinterpret_cast<const float *>(data);
     } else {
-      std::fill(buffer.begin(), buffer.end(), 0.0f);
+      buffer.resize(samples);
+      if (!silent && (is_pcm16 || is_ext16)) {
+        const int16_t *src = reinterpret_cast<const int16_t *>(data);
+        constexpr float scale = 1.0f / 32768.0f;
+        for (size_t i = 0; i < samples; ++i) {
+          buffer[i] = static_cast<float>(src[i]) * scale;
+        }
+      } else {
+        std::fill(buffer.begin(), buffer.end(), 0.0f);
+      }
+      interleaved = buffer.data();
     }
 
     mono.resize(frames);
-    for (UINT32 i = 0; i < frames; ++i) {
-      float sum = 0.0f;
-      for (UINT32 ch = 0; ch < channels; ++ch) {
-        sum += buffer[i * channels + ch];
-      }
-      mono[i] = sum / static_cast<float>(channels);
-    }
+    downmix.process(interleaved, frames, mono.data());
 
-    std::vector<float> output;
-    if (sample_rate_ == mix_rate) {
-      output = mono;
-    } else {
-      const size_t out_frames = std::max<size_t>(1, static_cast<size_t>(std::round(mono.size() / step)));
-      output.resize(out_frames);
-      for (size_t i = 0; i < out_frames; ++i) {
-        double src_pos = static_cast<double>(i) * step;
-        size_t idx = static_cast<size_t>(src_pos);
-        double frac = src_pos - static_cast<double>(idx);
-        float s0 = mono[std::min(idx, mono.size() - 1)];
-        float s1 = mono[std::min(idx + 1, mono.size() - 1)];
-        output[i] = s0 + static_cast<float>(frac) * (s1 - s0);
-      }
+    std::span<const float> out_span(mono);
+    if (!resampler.passthrough()) {
+      resampler.process(mono, output);
+      out_span = output;
     }
 
     if (!silent && !logged_first_packet) {
@@ -248,8 +322,9 @@ void AudioWin::run_loop() {
       logged_first_packet = true;
     }
 
-    if (handler_ && !output.empty()) {
-      handler_(output);
+    if (handler_ && !out_span.empty()) {
+      handler_(out_span);
+      handoffs_.fetch_add(1, std::memory_order_relaxed);
     }
 
     capture->ReleaseBuffer(frames);
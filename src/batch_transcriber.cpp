@@ -0,0 +1,186 @@
+#include "batch_transcriber.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "offline_transcriber.h"
+
+namespace {
+struct Job {
+  std::filesystem::path input;
+  uint64_t size = 0;
+  int64_t mtime = 0;
+};
+
+bool is_wav(const std::filesystem::path &path) {
+  std::string ext = path.extension().string();
+  std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+  return ext == ".wav";
+}
+
+// A file counts as done only if it is unchanged since the journal entry.
+std::string journal_key(const std::string &name, uint64_t size, int64_t mtime) {
+  return std::to_string(size) + "\t" + std::to_string(mtime) + "\t" + name;
+}
+
+std::set<std::string> read_journal(const std::filesystem::path &path) {
+  std::set<std::string> done;
+  std::ifstream in(path);
+  std::string line;
+  while (std::getline(in, line)) {
+    // size, mtime, audio seconds, wall seconds, file name
+    std::istringstream fields(line);
+    std::string size, mtime, audio, wall, name;
+    if (std::getline(fields, size, '\t') && std::getline(fields, mtime, '\t') && std::getline(fields, audio, '\t') &&
+        std::getline(fields, wall, '\t') && std::getline(fields, name)) {
+      done.insert(size + "\t" + mtime + "\t" + name);
+    }
+  }
+  return done;
+}
+}  // namespace
+
+bool BatchTranscriber::run(const std::shared_ptr<AprilModel> &model, const std::filesystem::path &input_dir,
+                           const Options &options, const FileHandler &on_file, Summary &summary, std::string &error) {
+  summary = Summary{};
+  if (!model) {
+    error = "no model";
+    return false;
+  }
+  std::error_code ec;
+  const std::filesystem::path output_dir = options.output_dir.empty() ? input_dir : options.output_dir;
+  std::filesystem::create_directories(output_dir, ec);
+  const auto journal_path = output_dir / kJournalName;
+  const auto journal = read_journal(journal_path);
+  std::ofstream journal_out(journal_path, std::ios::app);
+  if (!journal_out) {
+    error = "cannot write " + journal_path.string();
+    return false;
+  }
+
+  std::vector<Job> jobs;
+  std::vector<FileResult> skipped;
+  for (const auto &entry : std::filesystem::directory_iterator(input_dir, ec)) {
+    if (!entry.is_regular_file() || !is_wav(entry.path())) {
+      continue;
+    }
+    Job job;
+    job.input = entry.path();
+    job.size = entry.file_size(ec);
+    job.mtime = static_cast<int64_t>(entry.last_write_time(ec).time_since_epoch().count());
+    const auto output = output_dir / job.input.filename().replace_extension(".txt");
+    if (journal.count(journal_key(job.input.filename().string(), job.size, job.mtime)) &&
+        std::filesystem::exists(output)) {
+      FileResult result;
+      result.input = job.input;
+      result.output = output;
+      result.ok = true;
+      result.skipped = true;
+      skipped.push_back(std::move(result));
+      continue;
+    }
+    jobs.push_back(std::move(job));
+  }
+  if (ec) {
+    error = "cannot list " + input_dir.string() + ": " + ec.message();
+    return false;
+  }
+  // Longest files first, so the pool does not end waiting on one big file.
+  std::sort(jobs.begin(), jobs.end(), [](const Job &a, const Job &b) { return a.size > b.size; });
+
+  std::mutex mutex;
+  summary.files = jobs.size() + skipped.size();
+  for (const auto &result : skipped) {
+    ++summary.skipped;
+    if (on_file) {
+      on_file(result);
+    }
+  }
+
+  const auto started = std::chrono::steady_clock::now();
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+    while (!(options.cancel && options.cancel->load(std::memory_order_relaxed))) {
+      const size_t index = next.fetch_add(1);
+      if (index >= jobs.size()) {
+        break;
+      }
+      const Job &job = jobs[index];
+      FileResult result;
+      result.input = job.input;
+      result.output = output_dir / job.input.filename().replace_extension(".txt");
+
+      // Written under a temporary name so a crash never leaves a partial
+      // transcript that looks finished.
+      auto partial = result.output;
+      partial += ".part";
+      std::ofstream out(partial, std::ios::trunc);
+      if (!out) {
+        result.error = "cannot write " + partial.string();
+      } else {
+        OfflineTranscriber transcriber;
+        OfflineTranscriber::Options file_options;
+        file_options.jobs = 1;
+        file_options.resample_quality = options.resample_quality;
+        file_options.cancel = options.cancel;
+        OfflineTranscriber::Result file_result;
+        result.ok = transcriber.run(
+            model, job.input, file_options,
+            [&](const AprilAsrEngine::TimedText &segment) { out << format_segment(segment) << '\n'; }, file_result,
+            result.error);
+        out.close();
+        result.audio_seconds = file_result.audio_seconds;
+        result.wall_seconds = file_result.wall_seconds;
+        result.segments = file_result.segments;
+        std::error_code rename_error;
+        if (result.ok && out) {
+          std::filesystem::rename(partial, result.output, rename_error);
+        }
+        if (!result.ok || !out || rename_error) {
+          if (result.error.empty()) {
+            result.error = "cannot write " + result.output.string();
+          }
+          result.ok = false;
+          std::filesystem::remove(partial, rename_error);
+        }
+      }
+
+      std::scoped_lock lock(mutex);
+      if (result.ok) {
+        journal_out << job.size << '\t' << job.mtime << '\t' << result.audio_seconds << '\t' << result.wall_seconds
+                    << '\t' << job.input.filename().string() << '\n';
+        journal_out.flush();
+        summary.audio_seconds += result.audio_seconds;
+      } else {
+        ++summary.failed;
+      }
+      if (on_file) {
+        on_file(result);
+      }
+    }
+  };
+
+  unsigned workers = options.jobs != 0 ? options.jobs : std::max(1u, std::thread::hardware_concurrency());
+  workers = static_cast<unsigned>(std::min<size_t>(workers, std::max<size_t>(1, jobs.size())));
+  std::vector<std::thread> threads;
+  for (unsigned i = 1; i < workers; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  summary.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+  if (options.cancel && options.cancel->load(std::memory_order_relaxed)) {
+    error = "cancelled";
+    return false;
+  }
+  return summary.failed == 0;
+}
@@ -0,0 +1,115 @@
+#include "continuity_monitor.h"
+
+#include <algorithm>
+
+namespace {
+// Shorter shortfalls are indistinguishable from scheduling jitter.
+constexpr double kMinGapSeconds = 0.02;
+// Lets the baseline follow slow drift between the device and system clocks.
+constexpr double kBaselineLeak = 0.001;
+// Intermittent streams going idle look like long position jumps.
+constexpr double kMaxIntermittentGapSeconds = 0.5;
+}  // namespace
+
+void ContinuityMonitor::reset() {
+  frames_ = 0;
+  periods_ = 0;
+  gaps_ = 0;
+  lost_frames_ = 0;
+  discontinuities_ = 0;
+  restart_ = true;
+}
+
+void ContinuityMonitor::set_rate(uint32_t rate) {
+  rate_.store(rate, std::memory_order_relaxed);
+  restart_.store(true, std::memory_order_release);
+}
+
+void ContinuityMonitor::set_intermittent(bool intermittent) {
+  intermittent_ = intermittent;
+}
+
+uint64_t ContinuityMonitor::on_period(uint32_t frames, bool flagged) {
+  count_period(frames, flagged);
+  const auto now = std::chrono::steady_clock::now();
+  const double rate = static_cast<double>(rate_.load(std::memory_order_relaxed));
+  if (restart_.exchange(false, std::memory_order_acquire) || rate == 0.0) {
+    last_time_ = now;
+    lag_ = 0.0;
+    baseline_ = 0.0;
+    suspect_ = 0.0;
+    return 0;
+  }
+
+  // Frames that should have arrived since the last period, minus those that did.
+  lag_ += std::chrono::duration<double>(now - last_time_).count() * rate - static_cast<double>(frames);
+  last_time_ = now;
+  if (lag_ < baseline_) {
+    baseline_ = lag_;
+  } else {
+    baseline_ += (lag_ - baseline_) * kBaselineLeak;
+  }
+
+  // A late callback is followed by an early one; a real gap keeps the lag up.
+  // Only a shortfall seen on two consecutive periods is counted.
+  const double excess = lag_ - baseline_;
+  const double threshold = std::max(2.0 * static_cast<double>(frames), rate * kMinGapSeconds);
+  if (excess <= threshold) {
+    suspect_ = 0.0;
+    return 0;
+  }
+  if (suspect_ == 0.0) {
+    suspect_ = excess;
+    return 0;
+  }
+  const double lost = std::min(suspect_, excess);
+  baseline_ += lost;
+  suspect_ = 0.0;
+  record_gap(static_cast<uint64_t>(lost));
+  return static_cast<uint64_t>(lost);
+}
+
+uint64_t ContinuityMonitor::on_period_at(uint32_t frames, uint64_t device_position, bool flagged) {
+  count_period(frames, flagged);
+  const uint64_t expected = next_position_;
+  next_position_ = device_position + frames;
+  if (restart_.exchange(false, std::memory_order_acquire) || device_position <= expected) {
+    return 0;
+  }
+
+  const uint64_t lost = device_position - expected;
+  if (intermittent_) {
+    const double rate = static_cast<double>(rate_.load(std::memory_order_relaxed));
+    if (!flagged || rate == 0.0 || static_cast<double>(lost) > rate * kMaxIntermittentGapSeconds) {
+      return 0;
+    }
+  }
+  record_gap(lost);
+  return lost;
+}
+
+ContinuityMonitor::Counters ContinuityMonitor::counters() const {
+  Counters c;
+  c.gaps = gaps_.load(std::memory_order_acquire);
+  c.frames = frames_.load(std::memory_order_relaxed);
+  c.periods = periods_.load(std::memory_order_relaxed);
+  c.lost_frames = lost_frames_.load(std::memory_order_relaxed);
+  c.discontinuities = discontinuities_.load(std::memory_order_relaxed);
+  c.rate = rate_.load(std::memory_order_relaxed);
+  return c;
+}
+
+void ContinuityMonitor::count_period(uint32_t frames, bool flagged) {
+  frames_.fetch_add(frames, std::memory_order_relaxed);
+  periods_.fetch_add(1, std::memory_order_relaxed);
+  if (flagged) {
+    discontinuities_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void ContinuityMonitor::record_gap(uint64_t lost) {
+  // Written before the gap count so a reader that sees the new count also
+  // sees its frames.
+  lost_frames_.fetch_add(lost, std::memory_order_relaxed);
+  gaps_.fetch_add(1, std::memory_order_release);
+}
@@ -0,0 +1,24 @@
+#include "cpu_features.h"
+
+namespace {
+CpuFeatures detect() {
+  CpuFeatures f;
+#if defined(SIMD_X86)
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_cpu_init();
+  f.sse2 = __builtin_cpu_supports("sse2");
+  f.avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+  f.sse2 = true;
+#endif
+#elif defined(SIMD_NEON)
+  f.neon = true;
+#endif
+  return f;
+}
+}  // namespace
+
+const CpuFeatures &cpu_features() {
+  static const CpuFeatures features = detect();
+  return features;
+}
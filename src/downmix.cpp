@@ -0,0 +1,207 @@
+#include "downmix.h"
+
+#include "cpu_features.h"
+
+#if defined(SIMD_X86)
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+float speech_weight(ChannelPosition pos) {
+  switch (pos) {
+  case ChannelPosition::Mono:
+  case ChannelPosition::FrontCenter:
+    return 2.0f;
+  case ChannelPosition::FrontLeft:
+  case ChannelPosition::FrontRight:
+  case ChannelPosition::FrontLeftCenter:
+  case ChannelPosition::FrontRightCenter:
+  case ChannelPosition::Unknown:
+    return 1.0f;
+  case ChannelPosition::SideLeft:
+  case ChannelPosition::SideRight:
+  case ChannelPosition::RearLeft:
+  case ChannelPosition::RearRight:
+  case ChannelPosition::RearCenter:
+    return 0.5f;
+  case ChannelPosition::LowFrequency:
+    return 0.0f;
+  }
+  return 1.0f;
+}
+
+void downmix_scalar(const float *in, size_t frames, size_t channels, const float *w, float *out) {
+  for (size_t i = 0; i < frames; ++i) {
+    const float *frame = in + i * channels;
+    float sum = 0.0f;
+    for (size_t ch = 0; ch < channels; ++ch) {
+      sum += frame[ch] * w[ch];
+    }
+    out[i] = sum;
+  }
+}
+
+#if defined(SIMD_X86)
+void downmix_stereo_sse2(const float *in, size_t frames, const float *w, float *out) {
+  const __m128 wl = _mm_set1_ps(w[0]);
+  const __m128 wr = _mm_set1_ps(w[1]);
+  size_t i = 0;
+  for (; i + 4 <= frames; i += 4) {
+    __m128 a = _mm_loadu_ps(in + i * 2);
+    __m128 b = _mm_loadu_ps(in + i * 2 + 4);
+    __m128 l = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 r = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+    _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(l, wl), _mm_mul_ps(r, wr)));
+  }
+  downmix_scalar(in + i * 2, frames - i, 2, w, out + i);
+}
+
+void downmix_generic_sse2(const float *in, size_t frames, size_t channels, const float *w, float *out) {
+  const size_t vec = channels & ~size_t(3);
+  for (size_t i = 0; i < frames; ++i) {
+    const float *frame = in + i * channels;
+    __m128 acc = _mm_setzero_ps();
+    for (size_t ch = 0; ch < vec; ch += 4) {
+      acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(frame + ch), _mm_load_ps(w + ch)));
+    }
+    __m128 shuf = _mm_shuffle_ps(acc, acc, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(acc, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    float sum = _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+    for (size_t ch = vec; ch < channels; ++ch) {
+      sum += frame[ch] * w[ch];
+    }
+    out[i] = sum;
+  }
+}
+
+#if defined(SIMD_AVX2)
+// Eight frames per step, one gather per channel.
+SIMD_TARGET_AVX2 void downmix_generic_avx2(const float *in, size_t frames, size_t channels, const float *w,
+                                           float *out) {
+  const int stride = static_cast<int>(channels);
+  const __m256i index = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+  size_t i = 0;
+  for (; i + 8 <= frames; i += 8) {
+    const float *block = in + i * channels;
+    __m256 acc = _mm256_setzero_ps();
+    for (size_t ch = 0; ch < channels; ++ch) {
+      if (w[ch] == 0.0f) {
+        continue;
+      }
+      __m256 v = _mm256_i32gather_ps(block + ch, index, 4);
+      acc = _mm256_fmadd_ps(v, _mm256_set1_ps(w[ch]), acc);
+    }
+    _mm256_storeu_ps(out + i, acc);
+  }
+  downmix_generic_sse2(in + i * channels, frames - i, channels, w, out + i);
+}
+#endif
+#elif defined(SIMD_NEON)
+void downmix_stereo_neon(const float *in, size_t frames, const float *w, float *out) {
+  const float32x4_t wl = vdupq_n_f32(w[0]);
+  const float32x4_t wr = vdupq_n_f32(w[1]);
+  size_t i = 0;
+  for (; i + 4 <= frames; i += 4) {
+    float32x4x2_t lr = vld2q_f32(in + i * 2);
+    vst1q_f32(out + i, vmlaq_f32(vmulq_f32(lr.val[0], wl), lr.val[1], wr));
+  }
+  downmix_scalar(in + i * 2, frames - i, 2, w, out + i);
+}
+
+void downmix_generic_neon(const float *in, size_t frames, size_t channels, const float *w, float *out) {
+  const size_t vec = channels & ~size_t(3);
+  for (size_t i = 0; i < frames; ++i) {
+    const float *frame = in + i * channels;
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (size_t ch = 0; ch < vec; ch += 4) {
+      acc = vmlaq_f32(acc, vld1q_f32(frame + ch), vld1q_f32(w + ch));
+    }
+    float sum = vaddvq_f32(acc);
+    for (size_t ch = vec; ch < channels; ++ch) {
+      sum += frame[ch] * w[ch];
+    }
+    out[i] = sum;
+  }
+}
+#endif
+}  // namespace
+
+bool Downmixer::configure(size_t channels, std::span<const ChannelPosition> layout) {
+  if (channels == 0 || channels > kMaxChannels) {
+    return false;
+  }
+  std::vector<ChannelPosition> fallback;
+  if (layout.size() != channels) {
+    fallback = default_layout(channels);
+    layout = fallback;
+  }
+  weights_.fill(0.0f);
+  float total = 0.0f;
+  for (size_t ch = 0; ch < channels; ++ch) {
+    weights_[ch] = speech_weight(layout[ch]);
+    total += weights_[ch];
+  }
+  for (size_t ch = 0; ch < channels; ++ch) {
+    weights_[ch] = total > 0.0f ? weights_[ch] / total : 1.0f / static_cast<float>(channels);
+  }
+  channels_ = channels;
+  return true;
+}
+
+void Downmixer::process(const float *interleaved, size_t frames, float *mono) const {
+  if (channels_ == 0 || frames == 0) {
+    return;
+  }
+  const float *w = weights_.data();
+#if defined(SIMD_X86)
+  const auto &cpu = cpu_features();
+  if (channels_ == 2 && cpu.sse2) {
+    downmix_stereo_sse2(interleaved, frames, w, mono);
+    return;
+  }
+#if defined(SIMD_AVX2)
+  if (channels_ > 2 && cpu.avx2) {
+    downmix_generic_avx2(interleaved, frames, channels_, w, mono);
+    return;
+  }
+#endif
+  if (channels_ >= 4 && cpu.sse2) {
+    downmix_generic_sse2(interleaved, frames, channels_, w, mono);
+    return;
+  }
+#elif defined(SIMD_NEON)
+  if (channels_ == 2) {
+    downmix_stereo_neon(interleaved, frames, w, mono);
+    return;
+  }
+  if (channels_ >= 4) {
+    downmix_generic_neon(interleaved, frames, channels_, w, mono);
+    return;
+  }
+#endif
+  downmix_scalar(interleaved, frames, channels_, w, mono);
+}
+
+std::vector<ChannelPosition> Downmixer::default_layout(size_t channels) {
+  using P = ChannelPosition;
+  switch (channels) {
+  case 1:
+    return {P::Mono};
+  case 2:
+    return {P::FrontLeft, P::FrontRight};
+  case 3:
+    return {P::FrontLeft, P::FrontRight, P::FrontCenter};
+  case 4:
+    return {P::FrontLeft, P::FrontRight, P::RearLeft, P::RearRight};
+  case 6:
+    return {P::FrontLeft, P::FrontRight, P::FrontCenter, P::LowFrequency, P::RearLeft, P::RearRight};
+  case 8:
+    return {P::FrontLeft, P::FrontRight, P::FrontCenter, P::LowFrequency,
+            P::RearLeft, P::RearRight, P::SideLeft, P::SideRight};
+  default:
+    return std::vector<ChannelPosition>(channels, P::Unknown);
+  }
+}
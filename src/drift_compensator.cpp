@@ -0,0 +1,143 @@
+#include "drift_compensator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Occupancy jitters by a capture quantum or two; smooth over about a second.
+constexpr double kErrorTauSeconds = 1.0;
+// Gains in ppm per ms of error (and per ms-second for the integral). Chosen
+// for a critically damped loop settling in a couple of minutes, which is
+// slow enough that the ratio change is inaudible to the recognizer.
+constexpr double kProportional = 20.0;
+constexpr double kIntegral = 0.1;
+// Real clocks differ by tens of ppm; anything beyond this is a glitch.
+constexpr double kMaxPpm = 2000.0;
+// Offsets this large are not drift; drop the backlog and start over.
+constexpr double kResyncMs = 250.0;
+
+float cubic(float xm1, float x0, float x1, float x2, float t) {
+  return x0 + 0.5f * t * (x1 - xm1 + t * (2.0f * xm1 - 5.0f * x0 + 4.0f * x1 - x2 + t * (3.0f * (x0 - x1) + x2 - xm1)));
+}
+}  // namespace
+
+void DriftCompensator::configure(size_t sample_rate, size_t target_samples, size_t max_block) {
+  sample_rate_ = std::max<size_t>(1, sample_rate);
+  target_ = target_samples;
+  // A block at the maximum ratio plus interpolator context.
+  history_.assign(max_block + max_block / 256 + 8, 0);
+  reset();
+}
+
+void DriftCompensator::reset() {
+  history_len_ = 0;
+  pos_ = 0.0;
+  primed_ = false;
+  error_ms_ = 0.0;
+  integral_ppm_ = 0.0;
+  locked_ = false;
+  drift_ppm_ = 0.0;
+  offset_ms_ = 0.0;
+  underruns_ = 0;
+  resyncs_ = 0;
+}
+
+bool DriftCompensator::prime(SpscRing<short> &ring, size_t lead) {
+  const size_t avail = ring.size();
+  if (avail < lead + target_) {
+    return false;
+  }
+  size_t drop = avail - lead - target_;
+  while (drop > 0) {
+    const size_t n = ring.read(history_.data(), std::min(drop, history_.size()));
+    if (n == 0) {
+      break;
+    }
+    drop -= n;
+  }
+  // One sample of leading context for the interpolator.
+  history_[0] = 0;
+  history_len_ = 1;
+  pos_ = 1.0;
+  error_ms_ = 0.0;
+  primed_ = true;
+  locked_.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+void DriftCompensator::process(SpscRing<short> &ring, size_t lead, std::span<short> out) {
+  const size_t n = out.size();
+  if (n == 0) {
+    return;
+  }
+  if (!primed_ && !prime(ring, lead)) {
+    std::fill(out.begin(), out.end(), short{0});
+    return;
+  }
+
+  const double rate = static_cast<double>(sample_rate_);
+  const double dt = static_cast<double>(n) / rate;
+  const double queued = static_cast<double>(ring.size()) + (static_cast<double>(history_len_) - pos_);
+  const double error_ms = (queued - static_cast<double>(lead) - static_cast<double>(target_)) * 1000.0 / rate;
+  error_ms_ += (error_ms - error_ms_) * dt / (kErrorTauSeconds + dt);
+  if (std::abs(error_ms) > kResyncMs) {
+    resyncs_.fetch_add(1, std::memory_order_relaxed);
+    primed_ = false;
+    if (!prime(ring, lead)) {
+      locked_.store(false, std::memory_order_relaxed);
+      std::fill(out.begin(), out.end(), short{0});
+      return;
+    }
+  }
+
+  integral_ppm_ = std::clamp(integral_ppm_ + kIntegral * error_ms_ * dt, -kMaxPpm, kMaxPpm);
+  const double ppm = std::clamp(kProportional * error_ms_ + integral_ppm_, -kMaxPpm, kMaxPpm);
+  const double step = 1.0 + ppm * 1e-6;
+
+  // Top up the history with everything this block can touch.
+  const size_t need = std::min(static_cast<size_t>(pos_ + step * static_cast<double>(n - 1)) + 3, history_.size());
+  if (need > history_len_) {
+    history_len_ += ring.read(history_.data() + history_len_, need - history_len_);
+  }
+
+  size_t i = 0;
+  for (; i < n; ++i) {
+    const size_t idx = static_cast<size_t>(pos_);
+    if (idx + 2 >= history_len_) {
+      break;
+    }
+    const float t = static_cast<float>(pos_ - static_cast<double>(idx));
+    const float y = cubic(history_[idx - 1], history_[idx], history_[idx + 1], history_[idx + 2], t);
+    out[i] = static_cast<short>(std::lrintf(std::clamp(y, -32768.0f, 32767.0f)));
+    pos_ += step;
+  }
+  if (i < n) {
+    // The secondary stalled; play silence and re-prime once it recovers.
+    std::fill(out.begin() + static_cast<std::ptrdiff_t>(i), out.end(), short{0});
+    underruns_.fetch_add(1, std::memory_order_relaxed);
+    primed_ = false;
+    locked_.store(false, std::memory_order_relaxed);
+    return;
+  }
+
+  // Keep one sample before the read position as interpolator context.
+  const size_t base = static_cast<size_t>(pos_) - 1;
+  std::copy(history_.begin() + static_cast<std::ptrdiff_t>(base),
+            history_.begin() + static_cast<std::ptrdiff_t>(history_len_), history_.begin());
+  history_len_ -= base;
+  pos_ -= static_cast<double>(base);
+
+  drift_ppm_.store(integral_ppm_, std::memory_order_relaxed);
+  offset_ms_.store(error_ms_ + static_cast<double>(target_) * 1000.0 / rate, std::memory_order_relaxed);
+}
+
+DriftCompensator::Stats DriftCompensator::stats() const {
+  Stats s;
+  s.locked = locked_.load(std::memory_order_relaxed);
+  s.drift_ppm = drift_ppm_.load(std::memory_order_relaxed);
+  s.offset_ms = offset_ms_.load(std::memory_order_relaxed);
+  s.target_ms = static_cast<double>(target_) * 1000.0 / static_cast<double>(std::max<size_t>(1, sample_rate_));
+  s.underruns = underruns_.load(std::memory_order_relaxed);
+  s.resyncs = resyncs_.load(std::memory_order_relaxed);
+  return s;
+}
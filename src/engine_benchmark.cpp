@@ -0,0 +1,257 @@
+#include "engine_benchmark.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <thread>
+
+#include "downmix.h"
+#include "pcm_convert.h"
+#include "resampler.h"
+#include "voice_gate.h"
+#include "wav_reader.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+// Capture backends deliver about this much per callback.
+constexpr auto kPeriod = std::chrono::milliseconds(10);
+// After the last audio, how long to wait for results to stop arriving.
+constexpr auto kSettle = std::chrono::milliseconds(500);
+constexpr auto kSettleMax = std::chrono::seconds(5);
+
+// User plus system time of the whole process, april-asr's threads included.
+double process_cpu_seconds() {
+#if defined(_WIN32)
+  FILETIME created, exited, kernel, user;
+  if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) {
+    return 0.0;
+  }
+  auto seconds = [](const FILETIME &t) {
+    return static_cast<double>((static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime) * 1e-7;
+  };
+  return seconds(kernel) + seconds(user);
+#else
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+         static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+}
+
+std::vector<std::string> words(const std::string &text) {
+  std::vector<std::string> out;
+  std::string word;
+  for (const char c : text) {
+    const unsigned char u = static_cast<unsigned char>(c);
+    if (std::isalnum(u) || c == '\'' || u >= 0x80) {
+      word.push_back(static_cast<char>(std::tolower(u)));
+    } else if (!word.empty()) {
+      out.push_back(std::move(word));
+      word.clear();
+    }
+  }
+  if (!word.empty()) {
+    out.push_back(std::move(word));
+  }
+  return out;
+}
+
+void append_final(std::string &transcript, const std::string &text) {
+  const size_t first = text.find_first_not_of(' ');
+  if (first == std::string::npos) {
+    return;
+  }
+  if (!transcript.empty()) {
+    transcript.push_back(' ');
+  }
+  transcript.append(text, first, std::string::npos);
+}
+}  // namespace
+
+bool EngineBenchmark::load_audio(const std::filesystem::path &path, size_t rate, double max_seconds,
+                                 std::vector<short> &out, std::string &error) {
+  WavReader reader;
+  if (!reader.open(path, error)) {
+    return false;
+  }
+  Downmixer downmix;
+  Resampler resampler;
+  if (!downmix.configure(reader.channels()) || !resampler.configure(reader.rate(), rate, Resampler::Quality::High)) {
+    error = "cannot convert " + std::to_string(reader.rate()) + " Hz x " + std::to_string(reader.channels()) +
+            " ch to " + std::to_string(rate) + " Hz";
+    return false;
+  }
+  uint64_t frames_left = reader.frames();
+  if (max_seconds > 0.0) {
+    frames_left = std::min<uint64_t>(frames_left, static_cast<uint64_t>(max_seconds * reader.rate()));
+  }
+  const size_t block = reader.rate();
+  std::vector<float> interleaved(block * reader.channels());
+  std::vector<float> mono(block);
+  std::vector<float> resampled;
+  out.clear();
+  while (frames_left > 0) {
+    const size_t frames = reader.read(interleaved.data(), static_cast<size_t>(std::min<uint64_t>(block, frames_left)));
+    if (frames == 0) {
+      break;
+    }
+    frames_left -= frames;
+    downmix.process(interleaved.data(), frames, mono.data());
+    std::span<const float> converted(mono.data(), frames);
+    if (!resampler.passthrough()) {
+      resampler.process(converted, resampled);
+      converted = resampled;
+    }
+    const size_t offset = out.size();
+    out.resize(offset + converted.size());
+    float_to_pcm16(converted.data(), out.data() + offset, converted.size());
+  }
+  if (out.empty()) {
+    error = "no audio";
+    return false;
+  }
+  return true;
+}
+
+std::string EngineBenchmark::transcribe(const std::shared_ptr<AprilModel> &model, std::span<const short> audio) {
+  AprilAsrEngine engine;
+  std::string transcript;
+  if (!engine.set_model(model) || !engine.start(AprilAsrEngine::Mode::Synchronous)) {
+    return transcript;
+  }
+  engine.push_pcm16(audio);
+  engine.flush();
+  while (auto text = engine.poll_text()) {
+    append_final(transcript, *text);
+  }
+  return transcript;
+}
+
+bool EngineBenchmark::run(const std::shared_ptr<AprilModel> &model, std::span<const short> audio, const Config &config,
+                          Result &result) {
+  result = Result{};
+  result.config = config;
+  AprilAsrEngine engine;
+  engine.set_chunk_ms(config.chunk_ms);
+  if (!engine.set_model(model) || !engine.start(config.mode)) {
+    return false;
+  }
+  const size_t rate = engine.sample_rate();
+  const size_t period = rate * static_cast<size_t>(kPeriod.count()) / 1000;
+  std::vector<double> latencies;
+
+  // Wired as in live captioning: the gate passes everything on and flushes
+  // at pauses, and the engine's own silence report backs it up.
+  const bool finalize = config.finalize_pause_ms > 0;
+  VoiceGate gate;
+  if (finalize) {
+    VoiceGate::Config gate_config;
+    gate_config.pause_ms = config.finalize_pause_ms;
+    gate.configure(
+        rate, gate_config, [&](std::span<const short> samples) { engine.push_pcm16(samples); },
+        [&]() { engine.flush(); });
+  }
+  auto push = [&](std::span<const short> samples) {
+    if (!finalize) {
+      engine.push_pcm16(samples);
+      return;
+    }
+    gate.process(samples);
+    if (engine.take_silence_hint()) {
+      engine.flush();
+    }
+  };
+
+  const double cpu_start = process_cpu_seconds();
+  const auto start = std::chrono::steady_clock::now();
+  auto poll = [&]() {
+    bool any = false;
+    while (auto timed = engine.poll_timed_text()) {
+      any = true;
+      const auto captured = start + std::chrono::milliseconds(timed->end_ms);
+      const double latency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - captured).count();
+      latencies.push_back(std::max(0.0, latency));
+      append_final(result.transcript, timed->text);
+    }
+    result.max_speedup = std::max(result.max_speedup, engine.load_stats().speedup);
+    return any;
+  };
+
+  // Paced against the start time, so a mode that blocks the feeding thread
+  // falls behind rather than slowing the clock.
+  for (size_t offset = 0; offset < audio.size(); offset += period) {
+    std::this_thread::sleep_until(start + kPeriod * static_cast<int64_t>(offset / period));
+    push(audio.subspan(offset, std::min(period, audio.size() - offset)));
+    poll();
+  }
+  // The end-of-recording flush is not a forced final.
+  result.forced_finals = engine.flush_stats().flushes;
+  engine.flush();
+  const auto flushed = std::chrono::steady_clock::now();
+  auto last_result = flushed;
+  while (std::chrono::steady_clock::now() - last_result < kSettle && std::chrono::steady_clock::now() - flushed < kSettleMax) {
+    std::this_thread::sleep_for(kPeriod);
+    if (poll()) {
+      last_result = std::chrono::steady_clock::now();
+    }
+  }
+
+  result.audio_seconds = static_cast<double>(audio.size()) / static_cast<double>(rate);
+  result.wall_seconds = std::chrono::duration<double>(last_result - start).count();
+  result.cpu_seconds = process_cpu_seconds() - cpu_start;
+  result.cant_keep_up = engine.load_stats().cant_keep_up;
+  result.finals = latencies.size();
+  if (!latencies.empty()) {
+    double sum = 0.0;
+    for (const double latency : latencies) {
+      sum += latency;
+    }
+    result.mean_latency_ms = sum / static_cast<double>(latencies.size());
+    std::sort(latencies.begin(), latencies.end());
+    result.p95_latency_ms = latencies[std::min(latencies.size() - 1, latencies.size() * 95 / 100)];
+  }
+  return true;
+}
+
+double EngineBenchmark::word_error_rate(const std::string &reference, const std::string &hypothesis) {
+  const auto ref = words(reference);
+  const auto hyp = words(hypothesis);
+  if (ref.empty()) {
+    return hyp.empty() ? 0.0 : 1.0;
+  }
+  // Levenshtein distance over words, two rows at a time.
+  std::vector<size_t> prev(hyp.size() + 1);
+  std::vector<size_t> cur(hyp.size() + 1);
+  for (size_t j = 0; j <= hyp.size(); ++j) {
+    prev[j] = j;
+  }
+  for (size_t i = 1; i <= ref.size(); ++i) {
+    cur[0] = i;
+    for (size_t j = 1; j <= hyp.size(); ++j) {
+      const size_t substitute = prev[j - 1] + (ref[i - 1] == hyp[j - 1] ? 0 : 1);
+      cur[j] = std::min({substitute, prev[j] + 1, cur[j - 1] + 1});
+    }
+    std::swap(prev, cur);
+  }
+  return static_cast<double>(prev[hyp.size()]) / static_cast<double>(ref.size());
+}
+
+const char *EngineBenchmark::mode_name(AprilAsrEngine::Mode mode) {
+  switch (mode) {
+  case AprilAsrEngine::Mode::AsyncRealtime:
+    return "async-rt";
+  case AprilAsrEngine::Mode::AsyncNoRealtime:
+    return "async-no-rt";
+  case AprilAsrEngine::Mode::Synchronous:
+    return "synchronous";
+  }
+  return "";
+}
@@ -6,6 +6,7 @@
 #include <system_error>
 #include <string>
 #include <string_view>
+#include <span>
 #include <vector>
 #include <fstream>
 #include <cctype>
@@ -16,6 +17,7 @@
 #include <chrono>
 #include <thread>
 #include <atomic>
+#include <iterator>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -26,11 +28,23 @@
 #endif
 
 #include "april_asr.h"
+#include "audio_feeder.h"
+#include "audio_pipe.h"
+#include "batch_transcriber.h"
 #include "caption.h"
+#include "engine_benchmark.h"
 #include "transcription.h"
 #include "model.h"
+#include "model_cache.h"
+#include "model_loader.h"
+#include "model_prefetcher.h"
+#include "offline_transcriber.h"
+#include "pcm_convert.h"
 #include "profanity.h"
+#include "qos_controller.h"
 #include "app_update.h"
+#include "thread_policy.h"
+#include "voice_gate.h"
 
 #if defined(_WIN32)
 #include "audio_win.h"
@@ -83,6 +97,37 @@ struct AppSettings {
   bool lower_case = true;
   bool auto_check_updates = true;
   bool auto_update_models = true;
+  Resampler::Quality resample_quality = Resampler::Quality::Balanced;
+  // Off by default: PipeWire can always convert to mono PCM16 at the model
+  // rate, so asking for it hands downmixing and resampling to its adapter
+  // instead of our Downmixer and Resampler. On saves the float round-trip
+  // at the cost of their quality.
+  bool pcm16_capture = false;
+  bool skip_silence = false;
+  int vad_hangover_ms = 500;
+  int vad_preroll_ms = 300;
+  int finalize_pause_ms = 800;
+  float mix_mic_gain = 1.0f;
+  float mix_desktop_gain = 1.0f;
+  // With both sources, caption each in its own session instead of mixing.
+  bool separate_sources = false;
+  // Loaded models kept for quick switching back.
+  int model_cache_mb = 1024;
+  // Switch models at the next pause without stopping captions.
+  bool hot_swap_models = true;
+  // Read the models next to the active one into the OS file cache.
+  bool prefetch_models = true;
+  // Back off (UI frame rate, silence, model size) when decoding falls behind.
+  bool adaptive_load = true;
+  // AprilAsrEngine::Mode: realtime, full accuracy, or decoded on the feeder thread.
+  int engine_mode = 0;
+  // Audio reaches april-asr in chunks of this length; 0 as captured.
+  int engine_chunk_ms = 0;
+  int capture_latency_ms = 0;
+  int capture_batch_ms = 0;
+  ThreadPolicy capture_thread_policy;
+  ThreadPolicy feeder_thread_policy;
+  ThreadPolicy ui_thread_policy;
   int window_width = 1280;
   int window_height = 720;
 };
@@ -223,6 +268,86 @@ void load_settings(const std::filesystem::path &path, AppSettings &settings) {
       settings.auto_check_updates = line.find("=1") != std::string::npos;
     } else if (line.rfind("auto_update_models=", 0) == 0) {
       settings.auto_update_models = line.find("=1") != std::string::npos;
+    } else if (line.rfind("resample_quality=", 0) == 0) {
+      try {
+        int q = std::stoi(line.substr(std::string("resample_quality=").size()));
+        settings.resample_quality = static_cast<Resampler::Quality>(std::clamp(q, 0, 2));
+      } catch (...) {
+      }
+    } else if (line.rfind("pcm16_capture=", 0) == 0) {
+      settings.pcm16_capture = line.find("=1") != std::string::npos;
+    } else if (line.rfind("skip_silence=", 0) == 0) {
+      settings.skip_silence = line.find("=1") != std::string::npos;
+    } else if (line.rfind("separate_sources=", 0) == 0) {
+      settings.separate_sources = line.find("=1") != std::string::npos;
+    } else if (line.rfind("hot_swap_models=", 0) == 0) {
+      settings.hot_swap_models = line.find("=1") != std::string::npos;
+    } else if (line.rfind("prefetch_models=", 0) == 0) {
+      settings.prefetch_models = line.find("=1") != std::string::npos;
+    } else if (line.rfind("adaptive_load=", 0) == 0) {
+      settings.adaptive_load = line.find("=1") != std::string::npos;
+    } else if (line.rfind("engine_mode=", 0) == 0) {
+      try {
+        settings.engine_mode = std::clamp(std::stoi(line.substr(std::string("engine_mode=").size())), 0, 2);
+      } catch (...) {
+      }
+    } else if (line.rfind("engine_chunk_ms=", 0) == 0) {
+      try {
+        settings.engine_chunk_ms = std::clamp(std::stoi(line.substr(std::string("engine_chunk_ms=").size())), 0, 1000);
+      } catch (...) {
+      }
+    } else if (line.rfind("vad_hangover_ms=", 0) == 0) {
+      try {
+        settings.vad_hangover_ms = std::max(0, std::stoi(line.substr(std::string("vad_hangover_ms=").size())));
+      } catch (...) {
+      }
+    } else if (line.rfind("vad_preroll_ms=", 0) == 0) {
+      try {
+        settings.vad_preroll_ms = std::max(0, std::stoi(line.substr(std::string("vad_preroll_ms=").size())));
+      } catch (...) {
+      }
+    } else if (line.rfind("mix_mic_gain=", 0) == 0) {
+      try {
+        settings.mix_mic_gain = std::clamp(std::stof(line.substr(std::string("mix_mic_gain=").size())), 0.0f, 4.0f);
+      } catch (...) {
+      }
+    } else if (line.rfind("mix_desktop_gain=", 0) == 0) {
+      try {
+        settings.mix_desktop_gain = std::clamp(std::stof(line.substr(std::string("mix_desktop_gain=").size())), 0.0f, 4.0f);
+      } catch (...) {
+      }
+    } else if (line.rfind("capture_latency_ms=", 0) == 0) {
+      try {
+        settings.capture_latency_ms = std::clamp(std::stoi(line.substr(std::string("capture_latency_ms=").size())), 0, 1000);
+      } catch (...) {
+      }
+    } else if (line.rfind("capture_batch_ms=", 0) == 0) {
+      try {
+        settings.capture_batch_ms = std::clamp(std::stoi(line.substr(std::string("capture_batch_ms=").size())), 0, 1000);
+      } catch (...) {
+      }
+    } else if (line.rfind("capture_thread_policy=", 0) == 0) {
+      if (!parse_thread_policy(line.substr(std::string("capture_thread_policy=").size()), settings.capture_thread_policy)) {
+        log_error("Ignoring invalid " + line);
+      }
+    } else if (line.rfind("feeder_thread_policy=", 0) == 0) {
+      if (!parse_thread_policy(line.substr(std::string("feeder_thread_policy=").size()), settings.feeder_thread_policy)) {
+        log_error("Ignoring invalid " + line);
+      }
+    } else if (line.rfind("ui_thread_policy=", 0) == 0) {
+      if (!parse_thread_policy(line.substr(std::string("ui_thread_policy=").size()), settings.ui_thread_policy)) {
+        log_error("Ignoring invalid " + line);
+      }
+    } else if (line.rfind("model_cache_mb=", 0) == 0) {
+      try {
+        settings.model_cache_mb = std::max(0, std::stoi(line.substr(std::string("model_cache_mb=").size())));
+      } catch (...) {
+      }
+    } else if (line.rfind("finalize_pause_ms=", 0) == 0) {
+      try {
+        settings.finalize_pause_ms = std::max(0, std::stoi(line.substr(std::string("finalize_pause_ms=").size())));
+      } catch (...) {
+      }
     } else if (line.rfind("window_width=", 0) == 0) {
       try {
         settings.window_width = std::stoi(line.substr(std::string("window_width=").size()));
@@ -247,6 +372,17 @@ void save_settings(const std::filesystem::path &path, const AppSettings &setting
           line.rfind("auto_scroll=", 0) == 0 || line.rfind("break_lines=", 0) == 0 ||
           line.rfind("profanity_filter=", 0) == 0 || line.rfind("lower_case=", 0) == 0 ||
           line.rfind("auto_check_updates=", 0) == 0 || line.rfind("auto_update_models=", 0) == 0 ||
+          line.rfind("resample_quality=", 0) == 0 || line.rfind("pcm16_capture=", 0) == 0 ||
+          line.rfind("skip_silence=", 0) == 0 || line.rfind("vad_hangover_ms=", 0) == 0 ||
+          line.rfind("vad_preroll_ms=", 0) == 0 || line.rfind("finalize_pause_ms=", 0) == 0 ||
+          line.rfind("mix_mic_gain=", 0) == 0 || line.rfind("mix_desktop_gain=", 0) == 0 ||
+          line.rfind("separate_sources=", 0) == 0 || line.rfind("model_cache_mb=", 0) == 0 ||
+          line.rfind("hot_swap_models=", 0) == 0 || line.rfind("prefetch_models=", 0) == 0 ||
+          line.rfind("adaptive_load=", 0) == 0 || line.rfind("engine_mode=", 0) == 0 ||
+          line.rfind("engine_chunk_ms=", 0) == 0 ||
+          line.rfind("capture_latency_ms=", 0) == 0 || line.rfind("capture_batch_ms=", 0) == 0 ||
+          line.rfind("capture_thread_policy=", 0) == 0 || line.rfind("feeder_thread_policy=", 0) == 0 ||
+          line.rfind("ui_thread_policy=", 0) == 0 ||
           line.rfind("window_width=", 0) == 0 || line.rfind("window_height=", 0) == 0) {
         continue;
       }
@@ -261,6 +397,26 @@ void save_settings(const std::filesystem::path &path, const AppSettings &setting
   lines.push_back(std::string("lower_case=") + (settings.lower_case ? "1" : "0"));
   lines.push_back(std::string("auto_check_updates=") + (settings.auto_check_updates ? "1" : "0"));
   lines.push_back(std::string("auto_update_models=") + (settings.auto_update_models ? "1" : "0"));
+  lines.push_back(std::string("resample_quality=") + std::to_string(static_cast<int>(settings.resample_quality)));
+  lines.push_back(std::string("pcm16_capture=") + (settings.pcm16_capture ? "1" : "0"));
+  lines.push_back(std::string("skip_silence=") + (settings.skip_silence ? "1" : "0"));
+  lines.push_back(std::string("vad_hangover_ms=") + std::to_string(settings.vad_hangover_ms));
+  lines.push_back(std::string("vad_preroll_ms=") + std::to_string(settings.vad_preroll_ms));
+  lines.push_back(std::string("finalize_pause_ms=") + std::to_string(settings.finalize_pause_ms));
+  lines.push_back(std::string("mix_mic_gain=") + std::to_string(settings.mix_mic_gain));
+  lines.push_back(std::string("mix_desktop_gain=") + std::to_string(settings.mix_desktop_gain));
+  lines.push_back(std::string("separate_sources=") + (settings.separate_sources ? "1" : "0"));
+  lines.push_back(std::string("model_cache_mb=") + std::to_string(settings.model_cache_mb));
+  lines.push_back(std::string("hot_swap_models=") + (settings.hot_swap_models ? "1" : "0"));
+  lines.push_back(std::string("prefetch_models=") + (settings.prefetch_models ? "1" : "0"));
+  lines.push_back(std::string("adaptive_load=") + (settings.adaptive_load ? "1" : "0"));
+  lines.push_back(std::string("engine_mode=") + std::to_string(settings.engine_mode));
+  lines.push_back(std::string("engine_chunk_ms=") + std::to_string(settings.engine_chunk_ms));
+  lines.push_back(std::string("capture_latency_ms=") + std::to_string(settings.capture_latency_ms));
+  lines.push_back(std::string("capture_batch_ms=") + std::to_string(settings.capture_batch_ms));
+  lines.push_back("capture_thread_policy=" + format_thread_policy(settings.capture_thread_policy));
+  lines.push_back("feeder_thread_policy=" + format_thread_policy(settings.feeder_thread_policy));
+  lines.push_back("ui_thread_policy=" + format_thread_policy(settings.ui_thread_policy));
   lines.push_back(std::string("window_width=") + std::to_string(settings.window_width));
   lines.push_back(std::string("window_height=") + std::to_string(settings.window_height));
   std::ofstream out(path, std::ios::trunc);
@@ -327,23 +483,371 @@ bool open_folder(const std::filesystem::path &path) {
   return std::system(cmd.c_str()) == 0;
 #endif
 }
+
+// --model for the headless modes: a file name or stem from the models
+// folders, a path, or empty for the first model found.
+std::optional<std::filesystem::path> find_model(const std::filesystem::path &exe_path, bool use_dev_manifest,
+                                                const std::string &model_name) {
+  ModelManager model_manager(exe_path, use_dev_manifest);
+  model_manager.refresh();
+  for (const auto &path : model_manager.models()) {
+    if (model_name.empty() || path.filename().string() == model_name || path.stem().string() == model_name) {
+      return path;
+    }
+  }
+  if (!model_name.empty() && std::filesystem::exists(model_name)) {
+    return std::filesystem::path(model_name);
+  }
+  log_error(model_name.empty() ? "No caption models found. Add .april/.onnx/.ort files to models/."
+                               : "Model not found: " + model_name);
+  return std::nullopt;
+}
+
+// Headless --measure-model-load: times a load with the file dropped from the
+// OS file cache, the read-ahead the prefetcher does, a load right after it,
+// and a load of a file already cached.
+int run_measure_load(const std::filesystem::path &exe_path, bool use_dev_manifest, const std::string &model_name) {
+  const auto model = find_model(exe_path, use_dev_manifest, model_name);
+  if (!model) {
+    return 1;
+  }
+  std::error_code ec;
+  const uint64_t bytes = std::filesystem::file_size(*model, ec);
+  auto elapsed_ms = [](std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+  };
+  auto timed_load = [&](double &ms) {
+    const auto started = std::chrono::steady_clock::now();
+    const bool ok = AprilModel::load(*model) != nullptr;
+    ms = elapsed_ms(started);
+    return ok;
+  };
+  std::fprintf(stderr, "[info] Measuring loads of %s (%s)\n", model->filename().string().c_str(), format_size(bytes).c_str());
+
+  const bool evicted = ModelPrefetcher::evict(*model);
+  if (!evicted) {
+    std::fprintf(stderr, "[info] Cannot drop the file from the OS cache here; the first load may already be warm\n");
+  }
+  double cold_ms = 0.0;
+  if (!timed_load(cold_ms)) {
+    log_error("Failed to load model: " + model->filename().string());
+    return 1;
+  }
+
+  ModelPrefetcher::evict(*model);
+  const auto read_started = std::chrono::steady_clock::now();
+  ModelPrefetcher::read_through(*model);
+  const double read_ms = elapsed_ms(read_started);
+  double prefetched_ms = 0.0;
+  timed_load(prefetched_ms);
+
+  double warm_ms = 0.0;
+  timed_load(warm_ms);
+
+  const double mb_per_s = read_ms > 0.0 ? static_cast<double>(bytes) / (1024.0 * 1024.0) / (read_ms / 1000.0) : 0.0;
+  std::fprintf(stderr, "[info] %s load: %.0f ms\n", evicted ? "Cold" : "First", cold_ms);
+  std::fprintf(stderr, "[info] Read-ahead: %.0f ms (%.0f MB/s), then load: %.0f ms\n", read_ms, mb_per_s,
+               prefetched_ms);
+  std::fprintf(stderr, "[info] Warm load: %.0f ms\n", warm_ms);
+  return 0;
+}
+
+// Loads the model, the first seconds of the recording and the transcript the
+// benchmarks score against: --reference when given, otherwise an unpaced
+// synchronous transcript of the same audio.
+bool load_benchmark(const std::filesystem::path &exe_path, bool use_dev_manifest, const std::filesystem::path &input,
+                    const std::string &model_name, const std::string &reference_path, double seconds,
+                    std::shared_ptr<AprilModel> &loaded, std::vector<short> &audio, std::string &reference) {
+  const auto model = find_model(exe_path, use_dev_manifest, model_name);
+  if (!model) {
+    return false;
+  }
+  loaded = AprilModel::load(*model);
+  if (!loaded) {
+    log_error("Failed to load model: " + model->filename().string());
+    return false;
+  }
+  std::string error;
+  if (!EngineBenchmark::load_audio(input, loaded->sample_rate(), seconds, audio, error)) {
+    log_error("Cannot read " + input.string() + ": " + error);
+    return false;
+  }
+
+  if (!reference_path.empty()) {
+    std::ifstream in(reference_path);
+    if (!in) {
+      log_error("Cannot read reference: " + reference_path);
+      return false;
+    }
+    reference.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  } else {
+    reference = EngineBenchmark::transcribe(loaded, audio);
+  }
+  const double audio_seconds = static_cast<double>(audio.size()) / static_cast<double>(loaded->sample_rate());
+  std::fprintf(stderr, "[info] %s with %s: %.1f s of audio per run\n", input.filename().string().c_str(),
+               model->filename().string().c_str(), audio_seconds);
+  return true;
+}
+
+// Headless --benchmark-modes: replays the start of a recording in realtime
+// through every engine mode and feed chunk size, and prints final latency,
+// process CPU and word error rate for each. Without --reference, accuracy is
+// measured against an unpaced synchronous transcript of the same audio.
+int run_benchmark_modes(const std::filesystem::path &exe_path, bool use_dev_manifest, const std::filesystem::path &input,
+                        const std::string &model_name, const std::string &reference_path, double seconds) {
+  std::shared_ptr<AprilModel> loaded;
+  std::vector<short> audio;
+  std::string reference;
+  if (!load_benchmark(exe_path, use_dev_manifest, input, model_name, reference_path, seconds, loaded, audio,
+                      reference)) {
+    return 1;
+  }
+
+  const AprilAsrEngine::Mode modes[] = {AprilAsrEngine::Mode::AsyncRealtime, AprilAsrEngine::Mode::AsyncNoRealtime,
+                                        AprilAsrEngine::Mode::Synchronous};
+  const unsigned chunk_sizes[] = {0, 20, 50, 100};
+  std::printf("%-12s %-8s %7s %14s %8s %8s %8s %7s\n", "mode", "chunk", "finals", "latency avg/p95", "cpu",
+              "speedup", "keep-up", reference_path.empty() ? "diff" : "WER");
+  for (const auto mode : modes) {
+    for (const unsigned chunk_ms : chunk_sizes) {
+      EngineBenchmark::Result result;
+      if (!EngineBenchmark::run(loaded, audio, EngineBenchmark::Config{mode, chunk_ms}, result)) {
+        log_error(std::string("Cannot start a session in ") + EngineBenchmark::mode_name(mode) + " mode");
+        continue;
+      }
+      const std::string chunk = chunk_ms > 0 ? std::to_string(chunk_ms) + " ms" : "as fed";
+      std::printf("%-12s %-8s %7zu %6.0f/%5.0f ms %7.1f%% %7.2fx %8llu %6.1f%%\n", EngineBenchmark::mode_name(mode),
+                  chunk.c_str(), result.finals, result.mean_latency_ms, result.p95_latency_ms, result.cpu_percent(),
+                  result.max_speedup, static_cast<unsigned long long>(result.cant_keep_up),
+                  100.0 * EngineBenchmark::word_error_rate(reference, result.transcript));
+      std::fflush(stdout);
+    }
+  }
+  return 0;
+}
+
+// Headless --benchmark-finals: replays the start of a recording in realtime
+// with forced finals off, then forcing them after each pause the Finalize
+// After Pause menu offers, and prints how long each final took after the end
+// of its speech next to the word error rate, so the latency won can be
+// weighed against the accuracy lost to cutting phrases short.
+int run_benchmark_finals(const std::filesystem::path &exe_path, bool use_dev_manifest,
+                         const std::filesystem::path &input, const std::string &model_name,
+                         const std::string &reference_path, double seconds) {
+  std::shared_ptr<AprilModel> loaded;
+  std::vector<short> audio;
+  std::string reference;
+  if (!load_benchmark(exe_path, use_dev_manifest, input, model_name, reference_path, seconds, loaded, audio,
+                      reference)) {
+    return 1;
+  }
+
+  const int pauses[] = {0, 500, 800, 1200, 2000};
+  std::printf("%-10s %7s %7s %14s %8s %7s\n", "finalize", "finals", "forced", "latency avg/p95", "cpu",
+              reference_path.empty() ? "diff" : "WER");
+  for (const int pause : pauses) {
+    EngineBenchmark::Config config;
+    config.finalize_pause_ms = pause;
+    EngineBenchmark::Result result;
+    if (!EngineBenchmark::run(loaded, audio, config, result)) {
+      log_error("Cannot start a session");
+      return 1;
+    }
+    const std::string finalize = pause > 0 ? std::to_string(pause) + " ms" : "off";
+    std::printf("%-10s %7zu %7llu %6.0f/%5.0f ms %7.1f%% %6.1f%%\n", finalize.c_str(), result.finals,
+                static_cast<unsigned long long>(result.forced_finals), result.mean_latency_ms, result.p95_latency_ms,
+                result.cpu_percent(), 100.0 * EngineBenchmark::word_error_rate(reference, result.transcript));
+    std::fflush(stdout);
+  }
+  return 0;
+}
+
+// Headless --transcribe: decodes a WAV file as fast as the CPU allows and
+// writes one "[start --> end] text" line per final. Progress and the summary
+// go to stderr so the transcript can be piped. A directory is transcribed
+// file by file into --output (default: alongside the recordings).
+int run_transcribe(const std::filesystem::path &exe_path, bool use_dev_manifest, const std::filesystem::path &input,
+                   const std::string &model_name, std::string output, unsigned jobs) {
+  const auto model = find_model(exe_path, use_dev_manifest, model_name);
+  if (!model) {
+    return 1;
+  }
+
+  // One model shared by every parallel session and file.
+  auto loaded = AprilModel::load(*model);
+  if (!loaded) {
+    log_error("Failed to load model: " + model->filename().string());
+    return 1;
+  }
+
+  if (std::filesystem::is_directory(input)) {
+    BatchTranscriber batch;
+    BatchTranscriber::Options options;
+    options.jobs = jobs;
+    options.output_dir = output;
+    std::fprintf(stderr, "[info] Transcribing %s with %s\n", input.string().c_str(), model->filename().string().c_str());
+    BatchTranscriber::Summary summary;
+    std::string error;
+    const bool ok = batch.run(
+        loaded, input, options,
+        [](const BatchTranscriber::FileResult &file) {
+          const std::string name = file.input.filename().string();
+          if (file.skipped) {
+            std::fprintf(stderr, "[info] %s: already done\n", name.c_str());
+          } else if (file.ok) {
+            std::fprintf(stderr, "[info] %s: %.1f s of audio in %.1f s (%.3fx realtime), %zu segments\n", name.c_str(),
+                         file.audio_seconds, file.wall_seconds, file.realtime_factor(), file.segments);
+          } else {
+            std::fprintf(stderr, "[error] %s: %s\n", name.c_str(), file.error.c_str());
+          }
+        },
+        summary, error);
+    if (!error.empty()) {
+      log_error("Batch transcription failed: " + error);
+    }
+    std::fprintf(stderr, "[info] %zu files (%zu already done, %zu failed): %.1f s of audio in %.1f s (%.3fx realtime)\n",
+                 summary.files, summary.skipped, summary.failed, summary.audio_seconds, summary.wall_seconds,
+                 summary.realtime_factor());
+    return ok ? 0 : 1;
+  }
+
+  if (output.empty()) {
+    output = std::filesystem::path(input).replace_extension(".txt").string();
+  }
+  std::FILE *out = output == "-" ? stdout : std::fopen(output.c_str(), "w");
+  if (!out) {
+    log_error("Cannot write transcript: " + output);
+    return 1;
+  }
+  std::fprintf(stderr, "[info] Transcribing %s with %s\n", input.string().c_str(), model->filename().string().c_str());
+
+  OfflineTranscriber transcriber;
+  OfflineTranscriber::Options options;
+  options.jobs = jobs;
+  int last_percent = -1;
+  options.on_progress = [&](double fraction) {
+    const int percent = static_cast<int>(fraction * 100.0);
+    if (percent != last_percent) {
+      std::fprintf(stderr, "\r[info] %d%%", percent);
+      last_percent = percent;
+    }
+  };
+  OfflineTranscriber::Result result;
+  std::string error;
+  const bool ok = transcriber.run(
+      loaded, input, options,
+      [&](const AprilAsrEngine::TimedText &segment) {
+        std::fprintf(out, "%s\n", format_segment(segment).c_str());
+        std::fflush(out);
+      },
+      result, error);
+  if (out != stdout) {
+    std::fclose(out);
+  }
+  std::fprintf(stderr, "\n");
+  if (!ok) {
+    log_error("Transcription failed: " + error);
+    return 1;
+  }
+  std::fprintf(stderr, "[info] %.1f s of audio in %.1f s (%.3fx realtime), %zu segments from %zu chunks on %u jobs -> %s\n",
+               result.audio_seconds, result.wall_seconds, result.realtime_factor(), result.segments, result.chunks,
+               result.jobs, output == "-" ? "stdout" : output.c_str());
+  return 0;
+}
 } // namespace
-enum class AudioSourceKind { Desktop, Microphone };
+enum class AudioSourceKind { Desktop, Microphone, Both, Pipe };
 
 int run_app(int argc, char **argv) {
   (void)argc;
 
   bool use_dev_manifest = false;
   bool use_gpu = false;
+  // --input reads raw PCM from stdin ("-") or a named pipe instead of a device.
+  bool pipe_input = false;
+  AudioPipe::Config pipe_config;
+  std::string transcribe_path;
+  std::string transcribe_model;
+  std::string transcribe_output;
+  unsigned transcribe_jobs = 0;
+  bool measure_load = false;
+  std::string benchmark_path;
+  std::string benchmark_reference;
+  double benchmark_seconds = 30.0;
+  bool benchmark_finals = false;
   for (int i = 1; i < argc; ++i) {
     std::string a(argv[i]);
+    const bool has_value = i + 1 < argc;
     if (a == "--dev-manifest") {
       use_dev_manifest = true;
     } else if (a == "--gpu") {
       use_gpu = true;
+    } else if (a == "--transcribe" && has_value) {
+      transcribe_path = argv[++i];
+    } else if (a == "--benchmark-modes" && has_value) {
+      benchmark_path = argv[++i];
+    } else if (a == "--benchmark-finals" && has_value) {
+      benchmark_path = argv[++i];
+      benchmark_finals = true;
+    } else if (a == "--reference" && has_value) {
+      benchmark_reference = argv[++i];
+    } else if (a == "--bench-seconds" && has_value) {
+      try {
+        benchmark_seconds = std::max(0.0, std::stod(argv[++i]));
+      } catch (...) {
+        log_error(std::string("Invalid --bench-seconds: ") + argv[i]);
+        return 1;
+      }
+    } else if (a == "--measure-model-load") {
+      measure_load = true;
+    } else if (a == "--model" && has_value) {
+      transcribe_model = argv[++i];
+    } else if (a == "--output" && has_value) {
+      transcribe_output = argv[++i];
+    } else if (a == "--jobs" && has_value) {
+      try {
+        transcribe_jobs = static_cast<unsigned>(std::max(0, std::stoi(argv[++i])));
+      } catch (...) {
+        log_error(std::string("Invalid --jobs: ") + argv[i]);
+        return 1;
+      }
+    } else if (a == "--input" && has_value) {
+      pipe_input = true;
+      pipe_config.path = argv[++i];
+    } else if (a == "--input-format" && has_value) {
+      if (!AudioPipe::parse_format(argv[++i], pipe_config.format)) {
+        log_error(std::string("Unknown --input-format (expected s16le or f32le): ") + argv[i]);
+        return 1;
+      }
+    } else if ((a == "--input-rate" || a == "--input-channels") && has_value) {
+      int value = 0;
+      try {
+        value = std::stoi(argv[++i]);
+      } catch (...) {
+      }
+      if (value <= 0) {
+        log_error("Invalid " + a + ": " + argv[i]);
+        return 1;
+      }
+      (a == "--input-rate" ? pipe_config.rate : pipe_config.channels) = static_cast<uint32_t>(value);
     }
   }
 
+  if (!benchmark_path.empty() && benchmark_finals) {
+    return run_benchmark_finals(std::filesystem::absolute(argv[0]).parent_path(), use_dev_manifest, benchmark_path,
+                                transcribe_model, benchmark_reference, benchmark_seconds);
+  }
+  if (!benchmark_path.empty()) {
+    return run_benchmark_modes(std::filesystem::absolute(argv[0]).parent_path(), use_dev_manifest, benchmark_path,
+                               transcribe_model, benchmark_reference, benchmark_seconds);
+  }
+  if (measure_load) {
+    return run_measure_load(std::filesystem::absolute(argv[0]).parent_path(), use_dev_manifest, transcribe_model);
+  }
+  if (!transcribe_path.empty()) {
+    return run_transcribe(std::filesystem::absolute(argv[0]).parent_path(), use_dev_manifest, transcribe_path,
+                          transcribe_model, transcribe_output, transcribe_jobs);
+  }
+
   if (!glfwInit()) {
     return 1;
   }
@@ -396,11 +900,17 @@ int run_app(int argc, char **argv) {
   auto settings_path = settings_file(window_dir);
   AppSettings settings{};
   load_settings(settings_path, settings);
+  log_info("UI thread policy: " +
+           describe_thread_policy(settings.ui_thread_policy, apply_thread_policy(settings.ui_thread_policy)));
   if (settings.window_width > 0 && settings.window_height > 0) {
     glfwSetWindowSize(window, settings.window_width, settings.window_height);
   }
   ModelManager model_manager(exe_path, use_dev_manifest);
   model_manager.refresh();
+  ModelCache model_cache(static_cast<uint64_t>(settings.model_cache_mb) << 20);
+  ModelPrefetcher model_prefetcher;
+  // Models load in the background and are handed to the engine between frames.
+  ModelLoader model_loader(model_cache, &model_prefetcher);
   configure_fonts(exe_path, settings.font_size_px);
   configure_style();
   glfwSetWindowAttrib(window, GLFW_FLOATING, settings.always_on_top ? GLFW_TRUE : GLFW_FALSE);
@@ -418,7 +928,27 @@ int run_app(int argc, char **argv) {
   TranscriptionWriter writer;
   AprilAsrEngine engine;
   AudioBackend audio;
-  AudioSourceKind audio_source = AudioSourceKind::Desktop;
+  // Desktop capture when mixing both sources; `audio` is then the microphone.
+  AudioBackend aux_audio;
+  AudioPipe audio_pipe;
+  AudioFeeder feeder;
+  VoiceGate voice_gate;
+  // Desktop audio's own chain when both sources are captioned separately. Its
+  // session runs on the main engine's model; only session state is added.
+  AprilAsrEngine aux_engine;
+  AudioFeeder aux_feeder;
+  VoiceGate aux_voice_gate;
+  // Source switches start fresh sessions; a spare made ahead keeps that instant.
+  engine.keep_spare(true);
+  aux_engine.keep_spare(true);
+  engine.set_mode(static_cast<AprilAsrEngine::Mode>(settings.engine_mode));
+  aux_engine.set_mode(static_cast<AprilAsrEngine::Mode>(settings.engine_mode));
+  engine.set_chunk_ms(static_cast<unsigned>(settings.engine_chunk_ms));
+  aux_engine.set_chunk_ms(static_cast<unsigned>(settings.engine_chunk_ms));
+  bool split_sources = false;
+  // Model the engines switch to at their next pause.
+  std::optional<std::filesystem::path> hot_swap_model;
+  AudioSourceKind audio_source = pipe_input ? AudioSourceKind::Pipe : AudioSourceKind::Desktop;
   ProfanityFilter profanity;
   app_update::UpdateState update_state;
   if (settings.auto_check_updates) {
@@ -428,6 +958,7 @@ int run_app(int argc, char **argv) {
 
   if (settings.auto_update_models) {
     // On startup, check manifest and if updates exist, notify user (do not download automatically)
+    const DefaultThreadPolicyScope default_policy;
     model_update_thread = std::thread([&model_manager, &model_updates_available, &model_updates_list, &model_updates_mutex]() {
       std::vector<ModelManager::RemoteModel> manifest;
       std::string error;
@@ -455,43 +986,451 @@ int run_app(int argc, char **argv) {
     });
   }
 
+  log_info(std::string("Sample conversion kernel: ") + pcm_convert_kernel_name());
+
   auto models = model_manager.models();
   std::optional<std::filesystem::path> active_model;
   bool engine_ready = false;
   if (!models.empty()) {
     active_model = models.front();
     caption.set_active_model(active_model->filename().string());
-    engine_ready = engine.load_model(*active_model) && engine.start();
-    if (engine_ready) {
-      log_info("Loaded model: " + active_model->filename().string());
-    } else {
-      log_error("Failed to load model: " + active_model->filename().string());
-    }
-    if (!profanity.load(profanity_dir, detect_language_from_model(active_model->filename()))) {
-      log_error("Profanity list not found for model language: " + active_model->filename().string());
-    }
+    model_loader.request(*active_model);
   }
   if (!active_model) {
     log_error("No caption models found. Add .april/.onnx/.ort files to models/.");
   }
 
+  auto backend_source = [](bool desktop) {
+#if defined(_WIN32)
+    return desktop ? AudioBackend::Source::Loopback : AudioBackend::Source::Microphone;
+#else
+    return desktop ? 0 : 1;
+#endif
+  };
+
+  // Capture and feeder threads apply their policy themselves; it is reported
+  // once they have.
+  bool capture_policy_logged = false;
+  bool feeder_policy_logged = false;
+
+  auto start_capture = [&]() {
+    const char *source_name = audio_source == AudioSourceKind::Desktop      ? "Desktop"
+                              : audio_source == AudioSourceKind::Microphone ? "Microphone"
+                              : audio_source == AudioSourceKind::Pipe       ? "Pipe"
+                                                                            : "Desktop + Microphone";
+    log_info(std::string("Starting audio: ") + source_name + ", model rate " + std::to_string(engine.sample_rate()));
+    CaptureOptions capture_options;
+    capture_options.resample_quality = settings.resample_quality;
+    capture_options.latency_ms = settings.capture_latency_ms;
+    capture_options.batch_ms = settings.capture_batch_ms;
+    capture_options.thread_policy = settings.capture_thread_policy;
+    capture_policy_logged = false;
+    if (settings.pcm16_capture) {
+      capture_options.pcm16_handler = [&](std::span<const short> samples) { feeder.write_pcm16(samples); };
+    }
+    if (audio_source == AudioSourceKind::Pipe) {
+      // Pipe input waits for ring space instead of dropping, so a file piped
+      // in faster than realtime is throttled rather than truncated.
+      AudioPipe::Config config = pipe_config;
+      config.free_space = [&]() { return feeder.free_space(); };
+      if (!audio_pipe.start(engine.sample_rate(), config,
+                            [&](std::span<const float> samples) { feeder.write(samples); }, capture_options)) {
+        log_error("Failed to start pipe input");
+      }
+      return;
+    }
+    // The microphone is the clock master when mixing: it runs continuously,
+    // while loopback capture can stall when nothing is playing.
+    if (!audio.start(engine.sample_rate(), backend_source(audio_source == AudioSourceKind::Desktop),
+                     [&](std::span<const float> samples) { feeder.write(samples); }, capture_options)) {
+      log_error("Failed to start audio capture");
+    }
+    if (audio_source == AudioSourceKind::Both) {
+      CaptureOptions aux_options = capture_options;
+      AudioBackend::SampleHandler aux_handler;
+      if (split_sources) {
+        aux_handler = [&](std::span<const float> samples) { aux_feeder.write(samples); };
+        if (settings.pcm16_capture) {
+          aux_options.pcm16_handler = [&](std::span<const short> samples) { aux_feeder.write_pcm16(samples); };
+        }
+      } else {
+        aux_handler = [&](std::span<const float> samples) { feeder.write_aux(samples); };
+        if (settings.pcm16_capture) {
+          aux_options.pcm16_handler = [&](std::span<const short> samples) { feeder.write_aux_pcm16(samples); };
+        }
+      }
+      if (!aux_audio.start(engine.sample_rate(), backend_source(true), aux_handler, aux_options)) {
+        log_error("Failed to start desktop audio capture");
+      }
+    }
+  };
+
   auto start_audio = [&]() {
     if (!engine_ready) {
       return;
     }
-#if defined(_WIN32)
-    auto src = audio_source == AudioSourceKind::Desktop ? AudioBackend::Source::Loopback : AudioBackend::Source::Microphone;
-#else
-    int src = 0;
-#endif
-    log_info(std::string("Starting audio: ") + (audio_source == AudioSourceKind::Desktop ? "Desktop" : "Microphone") +
-             ", model rate " + std::to_string(engine.sample_rate()));
-    audio.start(engine.sample_rate(), src, [&](const std::vector<float> &samples) { engine.push_audio(samples); });
+    // The previous source's unfinished utterance is flushed into the captions;
+    // the model stays loaded.
+    const auto session_begin = std::chrono::steady_clock::now();
+    if (!engine.restart_session()) {
+      log_error("Failed to start caption session");
+      engine_ready = false;
+      return;
+    }
+    VoiceGate::Config gate_config;
+    gate_config.enabled = settings.skip_silence;
+    gate_config.hangover_ms = settings.vad_hangover_ms;
+    gate_config.preroll_ms = settings.vad_preroll_ms;
+    gate_config.pause_ms = settings.finalize_pause_ms;
+    voice_gate.configure(
+        engine.sample_rate(), gate_config, [&](std::span<const short> samples) { engine.push_pcm16(samples); },
+        [&]() { engine.flush(); });
+    const bool finalize_on_pause = settings.finalize_pause_ms > 0;
+    split_sources = audio_source == AudioSourceKind::Both && settings.separate_sources;
+    AudioFeeder::Options feeder_options;
+    feeder_options.mix_aux = audio_source == AudioSourceKind::Both && !split_sources;
+    feeder_options.main_gain = settings.mix_mic_gain;
+    feeder_options.aux_gain = settings.mix_desktop_gain;
+    // No point polling faster than capture hands audio over.
+    feeder_options.poll_ms = std::max(10, settings.capture_batch_ms);
+    feeder_options.thread_policy = settings.feeder_thread_policy;
+    // Pipe input already waits for room within the budget; a backlog left
+    // by a hold is drained rather than cut, so files are never truncated.
+    feeder_options.drop_late = audio_source != AudioSourceKind::Pipe;
+    // A synchronous engine decodes inside the sink; smaller pieces keep
+    // hold() from the UI thread waiting on a whole chunk's decode.
+    if (engine.mode() == AprilAsrEngine::Mode::Synchronous) {
+      feeder_options.slice_ms = 20;
+    }
+    feeder_policy_logged = false;
+    feeder.start(engine.sample_rate(), [&, finalize_on_pause](std::span<const short> samples) {
+      voice_gate.process(samples);
+      // The engine's own silence detection only sees ungated audio; it backs
+      // up the energy detector when pause finalization is enabled.
+      if (engine.take_silence_hint() && finalize_on_pause) {
+        engine.flush();
+      }
+    }, feeder_options);
+    if (split_sources) {
+      if ((aux_engine.model() == engine.model() || aux_engine.set_model(engine.model())) &&
+          aux_engine.restart_session()) {
+        aux_voice_gate.configure(
+            engine.sample_rate(), gate_config, [&](std::span<const short> samples) { aux_engine.push_pcm16(samples); },
+            [&]() { aux_engine.flush(); });
+        aux_feeder.start(engine.sample_rate(), [&, finalize_on_pause](std::span<const short> samples) {
+          aux_voice_gate.process(samples);
+          if (aux_engine.take_silence_hint() && finalize_on_pause) {
+            aux_engine.flush();
+          }
+        }, feeder_options);
+        log_info("Captioning desktop and microphone in separate sessions");
+      } else {
+        log_error("Failed to start desktop caption session; captioning microphone only");
+        split_sources = false;
+      }
+    }
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "Caption session ready in %.1f ms",
+                  std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - session_begin).count());
+    log_info(buf);
+    start_capture();
+  };
+
+  auto stop_audio = [&]() {
+    audio.stop();
+    aux_audio.stop();
+    audio_pipe.stop();
+    feeder.stop();
+    aux_feeder.stop();
+    // Nothing feeds the engine any more, so a pending swap would never find
+    // its pause.
+    engine.complete_swap();
+    aux_engine.complete_swap();
+    aux_engine.stop_session();
+    auto gate_stats = voice_gate.stats();
+    if (settings.skip_silence && gate_stats.processed_samples > 0) {
+      const double rate = static_cast<double>(std::max<size_t>(1, engine.sample_rate()));
+      char buf[128];
+      std::snprintf(buf, sizeof(buf), "Silence skipping: skipped %.1f s of %.1f s",
+                    static_cast<double>(gate_stats.skipped_samples) / rate,
+                    static_cast<double>(gate_stats.processed_samples) / rate);
+      log_info(buf);
+    }
   };
 
-  if (engine_ready) {
+  // Frees both sessions and drops their references to the model.
+  auto release_engines = [&]() {
+    aux_engine.stop();
+    engine.stop();
+    engine_ready = false;
+  };
+
+  // Only the capture backend restarts; the feeder keeps draining what was
+  // already captured.
+  auto restart_capture = [&]() {
+    const bool both = audio_source == AudioSourceKind::Both;
+    if (!feeder.running() || feeder.stats().mixing != (both && !settings.separate_sources) ||
+        split_sources != (both && settings.separate_sources)) {
+      stop_audio();
+      start_audio();
+      return;
+    }
+    audio.stop();
+    aux_audio.stop();
+    audio_pipe.stop();
+    start_capture();
+  };
+
+  // Capture keeps running into the feeder ring while the engine reloads, and
+  // the backlog is replayed into the new session. A model with a different
+  // sample rate needs a fresh capture chain, so that case still restarts.
+  auto switch_model = [&](const std::shared_ptr<AprilModel> &model) {
+    hot_swap_model.reset();
+    const bool live = feeder.running();
+    const size_t old_rate = engine.sample_rate();
+    if (live) {
+      feeder.hold();
+      aux_feeder.hold();
+    }
+    aux_engine.stop();
+    engine.stop();
+    engine_ready = engine.set_model(model) && engine.start(engine.mode());
+    if (!engine_ready) {
+      stop_audio();
+      return false;
+    }
+    if (live && engine.sample_rate() == old_rate) {
+      if (split_sources) {
+        aux_engine.set_model(engine.model());
+        aux_engine.start(engine.mode());
+        aux_voice_gate.reset();
+        aux_feeder.resume();
+      }
+      voice_gate.reset();
+      const double backlog = static_cast<double>(feeder.stats().fill) / static_cast<double>(std::max<size_t>(1, old_rate));
+      feeder.resume();
+      char buf[96];
+      std::snprintf(buf, sizeof(buf), "Replaying %.2f s of audio buffered during model switch", backlog);
+      log_info(buf);
+      return true;
+    }
+    stop_audio();
     start_audio();
-  }
+    return true;
+  };
+
+  // The models either side of the active one in the menu are the likeliest
+  // next picks; reading them ahead makes switching to one a warm load.
+  auto warm_likely_models = [&](const std::filesystem::path &path) {
+    if (!settings.prefetch_models) {
+      return;
+    }
+    auto it = std::find(models.begin(), models.end(), path);
+    if (it == models.end()) {
+      return;
+    }
+    const size_t index = static_cast<size_t>(it - models.begin());
+    std::vector<std::filesystem::path> likely;
+    for (size_t candidate : {index + 1, index + models.size() - 1}) {
+      const auto &next = models[candidate % models.size()];
+      if (next != path && !model_cache.contains(next) &&
+          std::find(likely.begin(), likely.end(), next) == likely.end()) {
+        likely.push_back(next);
+      }
+    }
+    model_prefetcher.warm(std::move(likely));
+  };
+
+  auto model_switched = [&](const std::filesystem::path &path) {
+    const std::string name = path.filename().string();
+    log_info("Loaded model: " + name);
+    if (!profanity.load(profanity_dir, detect_language_from_model(path.filename()))) {
+      log_error("Profanity list not found for model language: " + name);
+    }
+    warm_likely_models(path);
+  };
+
+  // Hands a model finished in the background to the engine. The previous
+  // model keeps captioning until then, and stays if loading failed. While
+  // live, the engines switch sessions themselves at the next pause.
+  auto apply_loaded_model = [&](const ModelLoader::Ready &ready) {
+    const std::string name = ready.path.filename().string();
+    if (!ready.model) {
+      log_error("Failed to load model: " + name);
+      if (engine_ready && engine.model()) {
+        active_model = engine.model()->path();
+        caption.set_active_model(active_model->filename().string());
+      }
+      return;
+    }
+    const auto cache_stats = model_cache.stats();
+    // A miss on a file read ahead beforehand was a warm load; compare with
+    // --measure-model-load for a cold one.
+    const bool was_warm = !ready.cache_hit && model_prefetcher.warmed(ready.path);
+    char buf[192];
+    std::snprintf(buf, sizeof(buf), "Model cache %s: %s ready after %.0f ms%s (%zu cached, %s)",
+                  ready.cache_hit ? "hit" : "miss", name.c_str(), ready.wait_ms, was_warm ? ", file read ahead" : "",
+                  cache_stats.entries, format_size(cache_stats.resident_bytes).c_str());
+    log_info(buf);
+    if (settings.hot_swap_models && engine_ready && feeder.running() &&
+        ready.model->sample_rate() == engine.sample_rate()) {
+      if (engine.stage_model(ready.model) && (!split_sources || aux_engine.stage_model(ready.model))) {
+        hot_swap_model = ready.path;
+        log_info("Switching to " + name + " at the next pause");
+        return;
+      }
+      log_error("Failed to prepare a session for " + name + "; restarting instead");
+    }
+    if (!switch_model(ready.model)) {
+      log_error("Failed to start model: " + name);
+      return;
+    }
+    model_switched(ready.path);
+  };
+
+  // Load control. Levels build on each other; each decision is logged.
+  QosController qos;
+  auto qos_sampled = std::chrono::steady_clock::now();
+  bool ui_throttled = false;
+  // What the user picked before load control fell back to a lighter model.
+  std::optional<std::filesystem::path> qos_replaced_model;
+
+  // The largest model of the same language that is smaller than `current`.
+  auto find_lighter_model = [&](const std::filesystem::path &current) {
+    std::optional<std::filesystem::path> lighter;
+    std::error_code ec;
+    const uint64_t current_size = std::filesystem::file_size(current, ec);
+    if (ec) {
+      return lighter;
+    }
+    const std::string language = detect_language_from_model(current.filename());
+    uint64_t best = 0;
+    for (const auto &candidate : models) {
+      const uint64_t size = std::filesystem::file_size(candidate, ec);
+      if (!ec && size < current_size && size > best &&
+          detect_language_from_model(candidate.filename()) == language) {
+        best = size;
+        lighter = candidate;
+      }
+    }
+    return lighter;
+  };
+  // find_lighter_model() of the active model, worked out again only when the
+  // active model or the model list changes rather than on every QoS tick.
+  struct LighterModel {
+    std::filesystem::path of;
+    std::optional<std::filesystem::path> lighter;
+  };
+  std::optional<LighterModel> lighter_model;
+  auto lighter_than_active = [&]() -> std::optional<std::filesystem::path> {
+    if (!active_model) {
+      return std::nullopt;
+    }
+    if (!lighter_model || lighter_model->of != *active_model) {
+      lighter_model = LighterModel{*active_model, find_lighter_model(*active_model)};
+    }
+    return lighter_model->lighter;
+  };
+
+  auto apply_qos_level = [&](QosController::Level level) {
+    ui_throttled = level >= QosController::Level::ReducedUi;
+    voice_gate.force_gating(level >= QosController::Level::SkipSilence);
+    aux_voice_gate.force_gating(level >= QosController::Level::SkipSilence);
+  };
+
+  auto reset_qos = [&]() {
+    qos.reset();
+    apply_qos_level(QosController::Level::Normal);
+    qos_replaced_model.reset();
+  };
+
+  auto on_qos_decision = [&](const QosController::Decision &decision) {
+    log_info(std::string("Load control: ") + QosController::name(decision.from) + " -> " +
+             QosController::name(decision.to) + " (" + decision.reason + ")");
+    apply_qos_level(decision.to);
+    if (decision.to == QosController::Level::LighterModel && active_model) {
+      if (auto lighter = lighter_than_active()) {
+        log_info("Load control: switching from " + active_model->filename().string() + " to " +
+                 lighter->filename().string());
+        qos_replaced_model = active_model;
+        active_model = lighter;
+        caption.set_active_model(active_model->filename().string());
+        model_loader.request(*active_model);
+      }
+    } else if (decision.from == QosController::Level::LighterModel && qos_replaced_model) {
+      // Going back could overload the CPU again; that is left to the user.
+      log_info("Load control: keeping " + (active_model ? active_model->filename().string() : std::string()) +
+               "; pick " + qos_replaced_model->filename().string() + " to go back");
+    }
+  };
+
+  struct GapTracker {
+    uint64_t gaps = 0;
+    uint64_t lost_frames = 0;
+  };
+  GapTracker main_gaps;
+  GapTracker aux_gaps;
+  // Marks audio the feeder dropped because recognition fell too far behind,
+  // like a capture gap.
+  uint64_t main_late = 0;
+  uint64_t aux_late = 0;
+  auto report_late = [&](const char *label, const AudioFeeder::Stats &stats, uint64_t &seen) {
+    if (stats.late_events < seen) {
+      seen = 0;  // Feeder restarted.
+    }
+    if (stats.late_events == seen) {
+      return;
+    }
+    seen = stats.late_events;
+    const double rate = static_cast<double>(std::max<size_t>(1, engine.sample_rate()));
+    char buf[128];
+    std::snprintf(buf, sizeof(buf), "[recognition behind: %.1f s of %s dropped so far]",
+                  static_cast<double>(stats.late_samples) / rate, label);
+    writer.write_line(buf);
+    log_error(std::string("Feeder ") + buf);
+  };
+  // Backends that negotiate the format asynchronously report it through
+  // their stats; it is logged here rather than from the audio callbacks.
+  uint32_t main_formats = 0;
+  uint32_t aux_formats = 0;
+  auto report_format = [&](const char *label, const CaptureStats &stats, uint32_t &seen) {
+    if (stats.format_changes < seen) {
+      seen = 0;  // Capture restarted.
+    }
+    if (stats.format_changes == seen) {
+      return;
+    }
+    seen = stats.format_changes;
+    char buf[128];
+    if (stats.format_channels == 0) {
+      std::snprintf(buf, sizeof(buf), "Capture format of %s cannot be converted (%u Hz)", label, stats.period_rate);
+      log_error(buf);
+    } else if (stats.format_direct) {
+      std::snprintf(buf, sizeof(buf), "Capture format of %s: %u Hz, S16 mono, direct", label, stats.period_rate);
+      log_info(buf);
+    } else {
+      std::snprintf(buf, sizeof(buf), "Capture format of %s: %u Hz, %u ch -> %zu Hz", label, stats.period_rate,
+                    stats.format_channels, engine.sample_rate());
+      log_info(buf);
+    }
+  };
+  // Puts a marker in the transcript whenever capture reports lost audio, so
+  // missing captions can be told apart from recognition misses.
+  auto report_gaps = [&](const char *label, const ContinuityMonitor::Counters &counters, GapTracker &seen) {
+    if (counters.gaps < seen.gaps) {
+      seen = GapTracker{};  // Capture restarted.
+    }
+    if (counters.gaps == seen.gaps || counters.rate == 0) {
+      return;
+    }
+    const double lost_sec = static_cast<double>(counters.lost_frames - seen.lost_frames) / counters.rate;
+    char buf[128];
+    std::snprintf(buf, sizeof(buf), "[audio gap: %.2f s of %s lost]", lost_sec, label);
+    writer.write_line(buf);
+    log_error(std::string("Capture ") + buf);
+    seen.gaps = counters.gaps;
+    seen.lost_frames = counters.lost_frames;
+  };
 
   bool rebuild_fonts = false;
   float pending_font_size = settings.font_size_px;
@@ -510,6 +1449,7 @@ int run_app(int argc, char **argv) {
     managed_ui.manifest.clear();
     managed_ui.selected.reset();
     managed_ui.fetch_inflight = true;
+    const DefaultThreadPolicyScope default_policy;
     managed_ui.fetch_future = std::async(std::launch::async, [&model_manager]() {
       ManagedModelFetchResult result;
       result.ok = model_manager.fetch_manifest(result.manifest, result.error);
@@ -531,15 +1471,18 @@ int run_app(int argc, char **argv) {
         managed_ui.pending_reload = model_manager.user_dir() / it->second.filename;
         caption.clear();
         caption.set_active_model(std::string());
-        audio.stop();
-        engine.stop();
-        engine_ready = false;
+        model_loader.cancel();
+        stop_audio();
+        release_engines();
+        // The file is about to be replaced; nothing may keep it loaded.
+        model_cache.erase(*active_model);
         active_model.reset();
         log_info(std::string("Unloaded active model for reinstall: id=") + remote.id + " filename=" + it->second.filename);
       }
     }
     managed_ui.download_target_id = remote.id;
     managed_ui.download_inflight = true;
+    const DefaultThreadPolicyScope default_policy;
     managed_ui.download_future = std::async(std::launch::async, [&model_manager, remote]() {
       ManagedModelDownloadResult result;
       result.remote = remote;
@@ -553,55 +1496,134 @@ int run_app(int argc, char **argv) {
     if (model_update_refresh.exchange(false)) {
       refresh_models = true;
     }
-    glfwPollEvents();
+    if (ui_throttled) {
+      // About 15 frames per second; input still wakes the loop at once.
+      glfwWaitEventsTimeout(1.0 / 15.0);
+    } else {
+      glfwPollEvents();
+    }
 
     if (refresh_models) {
       refresh_models = false;
       model_manager.refresh();
       auto updated = model_manager.models();
+      model_cache.prune(updated);
       if (!updated.empty()) {
         if (!active_model || std::find(updated.begin(), updated.end(), *active_model) == updated.end()) {
           active_model = updated.front();
           caption.clear();
           caption.set_active_model(active_model->filename().string());
-          audio.stop();
-          engine.stop();
-          engine_ready = engine.load_model(*active_model) && engine.start();
-          if (engine_ready) {
-            log_info("Loaded model: " + active_model->filename().string());
-            if (!profanity.load(profanity_dir, detect_language_from_model(active_model->filename()))) {
-              log_error("Profanity list not found for model language: " + active_model->filename().string());
-            }
-            start_audio();
-          } else {
-            log_error("Failed to load model: " + active_model->filename().string());
-          }
+          model_loader.request(*active_model);
         }
       } else {
+        model_loader.cancel();
         active_model.reset();
         caption.clear();
-        engine.stop();
-        engine_ready = false;
-        audio.stop();
+        stop_audio();
+        release_engines();
         log_error("No caption models found. Add .april/.onnx/.ort files to models/.");
       }
       models = std::move(updated);
+      lighter_model.reset();
     }
 
-    if (auto text = engine.poll_text()) {
-      auto normalized = lower_case_enabled ? apply_lower_case(*text) : *text;
-      auto filtered = profanity_filter_enabled ? profanity.filter(normalized) : normalized;
-      if (settings.break_lines && !caption.buffer().empty()) {
+    const auto capture_stats = audio_source == AudioSourceKind::Pipe ? audio_pipe.stats() : audio.stats();
+    report_gaps(audio_source == AudioSourceKind::Desktop      ? "desktop audio"
+                : audio_source == AudioSourceKind::Pipe       ? "pipe input"
+                                                              : "microphone audio",
+                capture_stats.continuity, main_gaps);
+    report_format(audio_source == AudioSourceKind::Both ? "microphone audio" : "capture", capture_stats, main_formats);
+    if (!capture_policy_logged && capture_stats.thread_policy.attempted) {
+      log_info("Capture thread policy: " + describe_thread_policy(settings.capture_thread_policy, capture_stats.thread_policy));
+      capture_policy_logged = true;
+    }
+    if (!feeder_policy_logged && feeder.running()) {
+      const auto feeder_policy = feeder.stats().thread_policy;
+      if (feeder_policy.attempted) {
+        log_info("Feeder thread policy: " + describe_thread_policy(settings.feeder_thread_policy, feeder_policy));
+        feeder_policy_logged = true;
+      }
+    }
+    if (feeder.running()) {
+      report_late("audio", feeder.stats(), main_late);
+    }
+    if (aux_feeder.running()) {
+      report_late("desktop audio", aux_feeder.stats(), aux_late);
+    }
+    if (audio_source == AudioSourceKind::Both) {
+      const auto aux_stats = aux_audio.stats();
+      report_gaps("desktop audio", aux_stats.continuity, aux_gaps);
+      report_format("desktop audio", aux_stats, aux_formats);
+    }
+
+    if (auto ready = model_loader.poll()) {
+      apply_loaded_model(*ready);
+    }
+    // Sampled once a second; with separate sources the busier session counts.
+    const auto now = std::chrono::steady_clock::now();
+    if (settings.adaptive_load && engine_ready && feeder.running() && !model_loader.pending() &&
+        now - qos_sampled >= std::chrono::seconds(1)) {
+      qos_sampled = now;
+      auto load = engine.load_stats();
+      if (split_sources) {
+        const auto aux_load = aux_engine.load_stats();
+        load.speedup = std::max(load.speedup, aux_load.speedup);
+        load.cant_keep_up += aux_load.cant_keep_up;
+      }
+      qos.set_max_level(lighter_than_active() ? QosController::Level::LighterModel
+                                              : QosController::Level::SkipSilence);
+      if (auto decision = qos.update(load.speedup, load.cant_keep_up, now)) {
+        on_qos_decision(*decision);
+      }
+    }
+    if (hot_swap_model && !engine.swap_pending() && !aux_engine.swap_pending()) {
+      // The engine may also have been stopped meanwhile, dropping the swap.
+      auto current = engine.model();
+      if (current && current->path() == *hot_swap_model) {
+        model_switched(*hot_swap_model);
+      }
+      hot_swap_model.reset();
+    }
+
+    // Separate sessions interleave in one caption view, a labelled line per final.
+    auto clean_text = [&](const std::string &text) {
+      auto normalized = lower_case_enabled ? apply_lower_case(text) : text;
+      return profanity_filter_enabled ? profanity.filter(normalized) : normalized;
+    };
+    auto append_final = [&](const std::string &text, const char *label) {
+      auto filtered = clean_text(text);
+      if ((settings.break_lines || label) && !caption.buffer().empty()) {
         caption.append("\n");
       }
+      if (label) {
+        filtered = std::string(label) + ": " + filtered;
+      }
       caption.append(filtered);
       writer.write_line(filtered);
+    };
+    const char *main_label = split_sources ? "Mic" : nullptr;
+    if (auto text = engine.poll_text()) {
+      append_final(*text, main_label);
+    }
+    // Also after leaving split mode: the desktop session's last utterance
+    // may still arrive.
+    if (auto text = aux_engine.poll_text()) {
+      append_final(*text, "Desktop");
     }
-    auto partial_raw = engine.peek_partial();
     std::optional<std::string> partial_filtered;
-    if (partial_raw && !partial_raw->empty()) {
-      auto normalized_partial = lower_case_enabled ? apply_lower_case(*partial_raw) : *partial_raw;
-      partial_filtered = profanity_filter_enabled ? profanity.filter(normalized_partial) : normalized_partial;
+    auto append_partial = [&](const std::optional<std::string> &partial_raw, const char *label) {
+      if (!partial_raw || partial_raw->empty()) {
+        return;
+      }
+      std::string text = partial_filtered.value_or(std::string());
+      if (label) {
+        text += (caption.buffer().empty() && text.empty() ? "" : "\n") + std::string(label) + ":";
+      }
+      partial_filtered = text + clean_text(*partial_raw);
+    };
+    append_partial(engine.peek_partial(), main_label);
+    if (split_sources) {
+      append_partial(aux_engine.peek_partial(), "Desktop");
     }
 
     if (managed_ui.fetch_inflight && managed_ui.fetch_future.valid() &&
@@ -631,18 +1653,7 @@ int run_app(int argc, char **argv) {
           active_model = result.path;
           caption.clear();
           caption.set_active_model(active_model->filename().string());
-          audio.stop();
-          engine.stop();
-          engine_ready = engine.load_model(*active_model) && engine.start();
-          if (engine_ready) {
-            if (!profanity.load(profanity_dir, detect_language_from_model(active_model->filename()))) {
-              log_error("Profanity list not found for model language: " + active_model->filename().string());
-            }
-            start_audio();
-            (void)0;
-          } else {
-            log_error("Failed to reload reinstalled model: " + active_model->filename().string());
-          }
+          model_loader.request(*active_model);
           managed_ui.pending_reload.reset();
         }
         refresh_models = true;
@@ -655,15 +1666,17 @@ int run_app(int argc, char **argv) {
           (void)0;
           caption.clear();
           caption.set_active_model(std::string());
-          audio.stop();
-          engine.stop();
-          engine_ready = false;
+          model_loader.cancel();
+          stop_audio();
+          release_engines();
+          model_cache.erase(*active_model);
           active_model.reset();
           (void)0;
         }
       }
       std::string id_copy = *managed_ui.pending_remove_id;
       (void)0;
+      const DefaultThreadPolicyScope default_policy;
       managed_ui.remove_future = std::async(std::launch::async, [&model_manager, id_copy]() {
         ManagedModelRemoveResult r;
         r.id = id_copy;
@@ -727,13 +1740,27 @@ int run_app(int argc, char **argv) {
       if (ImGui::BeginMenu("Audio Sources")) {
         if (ImGui::MenuItem("Desktop Audio", nullptr, audio_source == AudioSourceKind::Desktop)) {
           audio_source = AudioSourceKind::Desktop;
-          audio.stop();
-          start_audio();
+          restart_capture();
         }
         if (ImGui::MenuItem("Microphone", nullptr, audio_source == AudioSourceKind::Microphone)) {
           audio_source = AudioSourceKind::Microphone;
-          audio.stop();
-          start_audio();
+          restart_capture();
+        }
+        if (ImGui::MenuItem("Desktop + Microphone", nullptr, audio_source == AudioSourceKind::Both)) {
+          audio_source = AudioSourceKind::Both;
+          restart_capture();
+        }
+        if (pipe_input && ImGui::MenuItem("Pipe Input", nullptr, audio_source == AudioSourceKind::Pipe)) {
+          audio_source = AudioSourceKind::Pipe;
+          restart_capture();
+        }
+        ImGui::Separator();
+        if (ImGui::MenuItem("Separate Captions per Source", nullptr, settings.separate_sources)) {
+          settings.separate_sources = !settings.separate_sources;
+          save_settings(settings_path, settings);
+          if (audio_source == AudioSourceKind::Both) {
+            restart_capture();
+          }
         }
         ImGui::EndMenu();
       }
@@ -750,21 +1777,15 @@ int run_app(int argc, char **argv) {
         for (std::size_t i = 0; i < models.size(); ++i) {
           bool selected = active_model && *active_model == models[i];
           if (ImGui::MenuItem(models[i].filename().string().c_str(), nullptr, selected)) {
+            // The user's pick overrides any fallback load control made.
+            if (qos.level() != QosController::Level::Normal) {
+              log_info("Load control: reset by model choice");
+            }
+            reset_qos();
             active_model = models[i];
             caption.clear();
             caption.set_active_model(models[i].filename().string());
-            audio.stop();
-            engine.stop();
-            engine_ready = engine.load_model(*active_model) && engine.start();
-            if (engine_ready) {
-              log_info("Loaded model: " + active_model->filename().string());
-              if (!profanity.load(profanity_dir, detect_language_from_model(active_model->filename()))) {
-                log_error("Profanity list not found for model language: " + active_model->filename().string());
-              }
-              start_audio();
-            } else {
-              log_error("Failed to load model: " + active_model->filename().string());
-            }
+            model_loader.request(*active_model);
           }
         }
         ImGui::EndMenu();
@@ -790,6 +1811,7 @@ int run_app(int argc, char **argv) {
             if (model_update_thread.joinable()) {
               model_update_thread.join();
             }
+            const DefaultThreadPolicyScope default_policy;
             model_update_thread = std::thread([&model_manager, &model_updates_available, &model_updates_list, &model_updates_mutex]() {
               std::vector<ModelManager::RemoteModel> manifest;
               std::string error;
@@ -813,6 +1835,155 @@ int run_app(int argc, char **argv) {
             });
           }
         }
+        if (ImGui::BeginMenu("Model Cache")) {
+          const struct { const char *label; int mb; } budgets[] = {
+              {"Current Model Only", 0},
+              {"512 MB", 512},
+              {"1 GB", 1024},
+              {"2 GB", 2048},
+              {"4 GB", 4096},
+          };
+          for (const auto &opt : budgets) {
+            if (ImGui::MenuItem(opt.label, nullptr, settings.model_cache_mb == opt.mb) &&
+                settings.model_cache_mb != opt.mb) {
+              settings.model_cache_mb = opt.mb;
+              model_cache.set_budget(static_cast<uint64_t>(opt.mb) << 20);
+              save_settings(settings_path, settings);
+            }
+          }
+          ImGui::EndMenu();
+        }
+        if (ImGui::MenuItem("Read Ahead Likely Models", nullptr, settings.prefetch_models)) {
+          settings.prefetch_models = !settings.prefetch_models;
+          if (!settings.prefetch_models) {
+            model_prefetcher.warm({});
+          } else if (active_model) {
+            warm_likely_models(*active_model);
+          }
+          save_settings(settings_path, settings);
+        }
+        if (ImGui::MenuItem("Switch Models at Pauses", nullptr, settings.hot_swap_models)) {
+          settings.hot_swap_models = !settings.hot_swap_models;
+          save_settings(settings_path, settings);
+        }
+        ImGui::Separator();
+
+        ImGui::TextDisabled("Audio");
+        if (ImGui::BeginMenu("Resampler Quality")) {
+          const struct { const char *label; Resampler::Quality quality; } qualities[] = {
+              {"Fast", Resampler::Quality::Fast},
+              {"Balanced", Resampler::Quality::Balanced},
+              {"High", Resampler::Quality::High},
+          };
+          for (const auto &opt : qualities) {
+            if (ImGui::MenuItem(opt.label, nullptr, settings.resample_quality == opt.quality) &&
+                settings.resample_quality != opt.quality) {
+              settings.resample_quality = opt.quality;
+              save_settings(settings_path, settings);
+              restart_capture();
+            }
+          }
+          ImGui::EndMenu();
+        }
+        if (ImGui::BeginMenu("Recognizer Mode")) {
+          const struct { const char *label; AprilAsrEngine::Mode mode; } modes[] = {
+              {"Realtime (may lose accuracy)", AprilAsrEngine::Mode::AsyncRealtime},
+              {"Full Accuracy (may lag)", AprilAsrEngine::Mode::AsyncNoRealtime},
+              {"Synchronous on Feeder Thread", AprilAsrEngine::Mode::Synchronous},
+          };
+          for (const auto &opt : modes) {
+            if (ImGui::MenuItem(opt.label, nullptr, engine.mode() == opt.mode) && engine.mode() != opt.mode) {
+              settings.engine_mode = static_cast<int>(opt.mode);
+              save_settings(settings_path, settings);
+              log_info(std::string("Recognizer mode: ") + EngineBenchmark::mode_name(opt.mode));
+              // The running sessions are replaced on restart.
+              stop_audio();
+              engine.set_mode(opt.mode);
+              aux_engine.set_mode(opt.mode);
+              start_audio();
+            }
+          }
+          ImGui::EndMenu();
+        }
+        if (ImGui::BeginMenu("Feed Chunk Size")) {
+          const struct { const char *label; int ms; } chunks[] = {
+              {"As Captured", 0},
+              {"20 ms", 20},
+              {"50 ms", 50},
+              {"100 ms", 100},
+          };
+          for (const auto &opt : chunks) {
+            if (ImGui::MenuItem(opt.label, nullptr, settings.engine_chunk_ms == opt.ms) &&
+                settings.engine_chunk_ms != opt.ms) {
+              settings.engine_chunk_ms = opt.ms;
+              save_settings(settings_path, settings);
+              stop_audio();
+              engine.set_chunk_ms(static_cast<unsigned>(opt.ms));
+              aux_engine.set_chunk_ms(static_cast<unsigned>(opt.ms));
+              start_audio();
+            }
+          }
+          ImGui::EndMenu();
+        }
+        bool skip_silence_menu = settings.skip_silence;
+        if (ImGui::MenuItem("Skip Silence", nullptr, skip_silence_menu)) {
+          settings.skip_silence = !skip_silence_menu;
+          save_settings(settings_path, settings);
+          stop_audio();
+          start_audio();
+        }
+        if (ImGui::MenuItem("Adapt to CPU Load", nullptr, settings.adaptive_load)) {
+          settings.adaptive_load = !settings.adaptive_load;
+          if (!settings.adaptive_load) {
+            log_info("Load control: off");
+            reset_qos();
+          }
+          save_settings(settings_path, settings);
+        }
+#if !defined(_WIN32) && !defined(__APPLE__)
+        bool pcm16_menu = settings.pcm16_capture;
+        if (ImGui::MenuItem("Direct PCM16 Capture", nullptr, pcm16_menu)) {
+          settings.pcm16_capture = !pcm16_menu;
+          save_settings(settings_path, settings);
+          restart_capture();
+        }
+        if (ImGui::BeginMenu("Capture Latency")) {
+          const struct { const char *label; int ms; } latencies[] = {
+              {"Default", 0},
+              {"10 ms", 10},
+              {"20 ms", 20},
+              {"40 ms", 40},
+              {"80 ms", 80},
+          };
+          for (const auto &opt : latencies) {
+            if (ImGui::MenuItem(opt.label, nullptr, settings.capture_latency_ms == opt.ms) &&
+                settings.capture_latency_ms != opt.ms) {
+              settings.capture_latency_ms = opt.ms;
+              save_settings(settings_path, settings);
+              restart_capture();
+            }
+          }
+          ImGui::EndMenu();
+        }
+        if (ImGui::BeginMenu("Capture Batching")) {
+          const struct { const char *label; int ms; } batches[] = {
+              {"Off", 0},
+              {"20 ms", 20},
+              {"50 ms", 50},
+              {"100 ms", 100},
+          };
+          for (const auto &opt : batches) {
+            if (ImGui::MenuItem(opt.label, nullptr, settings.capture_batch_ms == opt.ms) &&
+                settings.capture_batch_ms != opt.ms) {
+              settings.capture_batch_ms = opt.ms;
+              save_settings(settings_path, settings);
+              stop_audio();
+              start_audio();
+            }
+          }
+          ImGui::EndMenu();
+        }
+#endif
         ImGui::Separator();
 
         ImGui::TextDisabled("Windows");
@@ -858,6 +2029,25 @@ int run_app(int argc, char **argv) {
           }
           ImGui::EndMenu();
         }
+        if (ImGui::BeginMenu("Finalize After Pause")) {
+          const struct { const char *label; int ms; } pauses[] = {
+              {"Off", 0},
+              {"0.5 s", 500},
+              {"0.8 s", 800},
+              {"1.2 s", 1200},
+              {"2 s", 2000},
+          };
+          for (const auto &opt : pauses) {
+            if (ImGui::MenuItem(opt.label, nullptr, settings.finalize_pause_ms == opt.ms) &&
+                settings.finalize_pause_ms != opt.ms) {
+              settings.finalize_pause_ms = opt.ms;
+              save_settings(settings_path, settings);
+              stop_audio();
+              start_audio();
+            }
+          }
+          ImGui::EndMenu();
+        }
         ImGui::Separator();
 
         ImGui::TextDisabled("Extras");
@@ -869,6 +2059,120 @@ int run_app(int argc, char **argv) {
         }
         ImGui::EndMenu();
       }
+      if (ImGui::BeginMenu("Diagnostics")) {
+        auto show_capture_stats = [](const char *label, const CaptureStats &stats) {
+          const double period_ms = stats.period_rate > 0 ? 1000.0 * stats.period_frames / stats.period_rate : 0.0;
+          ImGui::Text("%s: %u frames @ %u Hz (%.1f ms)", label, stats.period_frames, stats.period_rate, period_ms);
+          ImGui::Text("Wakeups: %.0f/s, handoffs: %.0f/s", stats.wakeups_per_sec, stats.handoffs_per_sec);
+          const auto &cont = stats.continuity;
+          const double rate = static_cast<double>(std::max<uint32_t>(1, cont.rate));
+          ImGui::Text("Captured: %.1f s in %llu periods", static_cast<double>(cont.frames) / rate,
+                      static_cast<unsigned long long>(cont.periods));
+          ImGui::Text("Gaps: %llu (%.2f s lost), flagged: %llu", static_cast<unsigned long long>(cont.gaps),
+                      static_cast<double>(cont.lost_frames) / rate, static_cast<unsigned long long>(cont.discontinuities));
+        };
+        ImGui::TextDisabled("Capture");
+        if (audio_source == AudioSourceKind::Pipe) {
+          show_capture_stats("Pipe read", audio_pipe.stats());
+          ImGui::Text("Input: %s", audio_pipe.finished() ? "ended" : audio_pipe.running() ? "reading" : "stopped");
+        } else {
+          show_capture_stats(audio_source == AudioSourceKind::Both ? "Microphone period" : "Period", audio.stats());
+        }
+        if (audio_source == AudioSourceKind::Both) {
+          show_capture_stats("Desktop period", aux_audio.stats());
+        }
+        ImGui::Separator();
+        auto feeder_stats = feeder.stats();
+        ImGui::TextDisabled("Audio Buffer");
+        ImGui::Text("Fill: %zu / %zu samples%s", feeder_stats.fill, feeder_stats.capacity,
+                    feeder_stats.held ? " (held)" : "");
+        ImGui::Text("Overflows: %llu (%llu samples dropped)",
+                    static_cast<unsigned long long>(feeder_stats.overflow_events),
+                    static_cast<unsigned long long>(feeder_stats.overflow_samples));
+        ImGui::Text("Dropped behind: %llu (%llu samples)", static_cast<unsigned long long>(feeder_stats.late_events),
+                    static_cast<unsigned long long>(feeder_stats.late_samples));
+        auto gate_stats = voice_gate.stats();
+        const double rate = static_cast<double>(std::max<size_t>(1, engine.sample_rate()));
+        const double skipped_pct = gate_stats.processed_samples > 0
+                                       ? 100.0 * static_cast<double>(gate_stats.skipped_samples) / static_cast<double>(gate_stats.processed_samples)
+                                       : 0.0;
+        ImGui::Separator();
+        ImGui::TextDisabled("Silence Skipping");
+        ImGui::Text("State: %s", !settings.skip_silence ? "Off" : (gate_stats.open ? "Speech" : "Silence"));
+        ImGui::Text("Skipped: %.1f s of %.1f s (%.0f%%)", static_cast<double>(gate_stats.skipped_samples) / rate,
+                    static_cast<double>(gate_stats.processed_samples) / rate, skipped_pct);
+        if (feeder_stats.mixing) {
+          ImGui::Separator();
+          ImGui::TextDisabled("Source Mix");
+          ImGui::Text("Desktop: %s", feeder_stats.drift.locked ? "Locked" : "Buffering");
+          ImGui::Text("Desktop buffer: %zu samples (%.1f ms ahead, target %.0f ms)", feeder_stats.aux_fill,
+                      feeder_stats.drift.offset_ms, feeder_stats.drift.target_ms);
+          ImGui::Text("Clock drift: %+.1f ppm", feeder_stats.drift.drift_ppm);
+          ImGui::Text("Underruns: %llu, resyncs: %llu", static_cast<unsigned long long>(feeder_stats.drift.underruns),
+                      static_cast<unsigned long long>(feeder_stats.drift.resyncs));
+        }
+        if (split_sources) {
+          ImGui::Separator();
+          ImGui::TextDisabled("Caption Sessions");
+          // Each engine holds one reference; the model itself is loaded once.
+          auto shared_model = engine.model();
+          ImGui::Text("Sessions: 2 on one model (%ld references)", shared_model ? shared_model.use_count() - 1 : 0L);
+          ImGui::Text("Desktop buffer: %zu samples", aux_feeder.stats().fill);
+        }
+        auto cache_stats = model_cache.stats();
+        ImGui::Separator();
+        ImGui::TextDisabled("Model Cache");
+        ImGui::Text("Loaded: %zu models, %s of %s", cache_stats.entries, format_size(cache_stats.resident_bytes).c_str(),
+                    format_size(cache_stats.budget_bytes).c_str());
+        ImGui::Text("Hits: %llu, misses: %llu, evictions: %llu", static_cast<unsigned long long>(cache_stats.hits),
+                    static_cast<unsigned long long>(cache_stats.misses),
+                    static_cast<unsigned long long>(cache_stats.evictions));
+        ImGui::Text("Last load: %.0f ms", cache_stats.last_load_ms);
+        auto prefetch_stats = model_prefetcher.stats();
+        if (auto reading = model_prefetcher.current()) {
+          ImGui::Text("Reading ahead: %s", reading->filename().string().c_str());
+        } else if (prefetch_stats.files > 0) {
+          ImGui::Text("Read ahead: %llu files, last %s in %.0f ms", static_cast<unsigned long long>(prefetch_stats.files),
+                      format_size(prefetch_stats.last_bytes).c_str(), prefetch_stats.last_ms);
+        }
+        auto swap_stats = engine.swap_stats();
+        if (swap_stats.swaps > 0) {
+          ImGui::Text("Hot swaps: %llu (%llu mid-utterance)", static_cast<unsigned long long>(swap_stats.swaps),
+                      static_cast<unsigned long long>(swap_stats.forced));
+          ImGui::Text("Last swap: waited %.0f ms, replayed %.0f ms", swap_stats.last_wait_ms,
+                      swap_stats.last_overlap_ms);
+        }
+        auto load_stats = engine.load_stats();
+        ImGui::Separator();
+        ImGui::TextDisabled("Recognizer Load");
+        if (engine.chunk_ms() > 0) {
+          ImGui::Text("Mode: %s, %u ms chunks", EngineBenchmark::mode_name(engine.mode()), engine.chunk_ms());
+        } else {
+          ImGui::Text("Mode: %s, chunks as captured", EngineBenchmark::mode_name(engine.mode()));
+        }
+        ImGui::Text("Realtime speedup: x%.2f (smoothed x%.2f)", load_stats.speedup, qos.speedup());
+        ImGui::Text("Keep-up errors: %llu", static_cast<unsigned long long>(load_stats.cant_keep_up));
+        ImGui::Text("Load control: %s", settings.adaptive_load ? QosController::name(qos.level()) : "Off");
+        if (qos_replaced_model) {
+          ImGui::Text("Replaced model: %s", qos_replaced_model->filename().string().c_str());
+        }
+        auto flush_stats = engine.flush_stats();
+        ImGui::Separator();
+        ImGui::TextDisabled("Utterance Endpointing");
+        ImGui::Text("Pauses detected: %llu", static_cast<unsigned long long>(gate_stats.pauses));
+        ImGui::Text("Forced finals: %llu", static_cast<unsigned long long>(flush_stats.flushes));
+        ImGui::Text("Last final latency: %.0f ms", flush_stats.last_latency_ms);
+        ImGui::EndMenu();
+      }
+      // Above x1 april-asr is skipping through audio and accuracy suffers.
+      if (engine_ready && (qos.speedup() > 1.0f || qos.level() != QosController::Level::Normal)) {
+        ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "CPU overloaded: x%.2f", qos.speedup());
+      }
+      if (auto loading = model_loader.pending()) {
+        ImGui::TextDisabled("Loading %s...", loading->filename().string().c_str());
+      } else if (hot_swap_model) {
+        ImGui::TextDisabled("Switching to %s at the next pause...", hot_swap_model->filename().string().c_str());
+      }
       ImGui::EndMainMenuBar();
     }
 
@@ -1220,8 +2524,8 @@ int run_app(int argc, char **argv) {
     }
   }
 
-  audio.stop();
-  engine.stop();
+  stop_audio();
+  release_engines();
   int saved_w = 0;
   int saved_h = 0;
   glfwGetWindowSize(window, &saved_w, &saved_h);
@@ -0,0 +1,108 @@
+#include "model_cache.h"
+
+#include <algorithm>
+#include <chrono>
+
+ModelCache::ModelCache(uint64_t budget_bytes) {
+  stats_.budget_bytes = budget_bytes;
+}
+
+void ModelCache::set_budget(uint64_t budget_bytes) {
+  std::scoped_lock lock(mutex_);
+  stats_.budget_bytes = budget_bytes;
+  evict_locked();
+}
+
+std::shared_ptr<AprilModel> ModelCache::get(const std::filesystem::path &path) {
+  std::error_code ec;
+  const uint64_t bytes = std::filesystem::file_size(path, ec);
+  const auto mtime = std::filesystem::last_write_time(path, ec);
+  {
+    std::scoped_lock lock(mutex_);
+    auto it = std::find_if(entries_.begin(), entries_.end(), [&](const Entry &e) { return e.path == path; });
+    if (it != entries_.end()) {
+      if (it->bytes == bytes && it->mtime == mtime) {
+        ++stats_.hits;
+        entries_.splice(entries_.begin(), entries_, it);
+        return entries_.front().model;
+      }
+      stats_.resident_bytes -= it->bytes;
+      entries_.erase(it);
+    }
+    ++stats_.misses;
+  }
+
+  // Loading takes seconds; other lookups are not held up meanwhile.
+  const auto started = std::chrono::steady_clock::now();
+  auto model = AprilModel::load(path);
+  if (!model) {
+    return nullptr;
+  }
+  const double load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+
+  std::scoped_lock lock(mutex_);
+  stats_.last_load_ms = load_ms;
+  auto it = std::find_if(entries_.begin(), entries_.end(), [&](const Entry &e) { return e.path == path; });
+  if (it != entries_.end()) {
+    // Loaded twice concurrently; keep the first.
+    entries_.splice(entries_.begin(), entries_, it);
+    return entries_.front().model;
+  }
+  entries_.push_front(Entry{path, model, bytes, mtime});
+  stats_.resident_bytes += bytes;
+  evict_locked();
+  return model;
+}
+
+bool ModelCache::contains(const std::filesystem::path &path) const {
+  std::error_code ec;
+  const uint64_t bytes = std::filesystem::file_size(path, ec);
+  const auto mtime = std::filesystem::last_write_time(path, ec);
+  std::scoped_lock lock(mutex_);
+  return std::any_of(entries_.begin(), entries_.end(),
+                     [&](const Entry &e) { return e.path == path && e.bytes == bytes && e.mtime == mtime; });
+}
+
+void ModelCache::erase(const std::filesystem::path &path) {
+  std::scoped_lock lock(mutex_);
+  auto it = std::find_if(entries_.begin(), entries_.end(), [&](const Entry &e) { return e.path == path; });
+  if (it != entries_.end()) {
+    stats_.resident_bytes -= it->bytes;
+    entries_.erase(it);
+  }
+}
+
+void ModelCache::prune(const std::vector<std::filesystem::path> &available) {
+  std::scoped_lock lock(mutex_);
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    if (std::find(available.begin(), available.end(), it->path) == available.end()) {
+      stats_.resident_bytes -= it->bytes;
+      ++stats_.evictions;
+      it = entries_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void ModelCache::clear() {
+  std::scoped_lock lock(mutex_);
+  entries_.clear();
+  stats_.resident_bytes = 0;
+}
+
+ModelCache::Stats ModelCache::stats() const {
+  std::scoped_lock lock(mutex_);
+  Stats s = stats_;
+  s.entries = entries_.size();
+  return s;
+}
+
+void ModelCache::evict_locked() {
+  // The newest entry always stays, even if it alone is over budget.
+  while (entries_.size() > 1 && stats_.resident_bytes > stats_.budget_bytes) {
+    stats_.resident_bytes -= entries_.back().bytes;
+    entries_.pop_back();
+    ++stats_.evictions;
+  }
+}
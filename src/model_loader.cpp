@@ -0,0 +1,91 @@
+#include "model_loader.h"
+
+#include <chrono>
+
+#include "thread_policy.h"
+
+ModelLoader::ModelLoader(ModelCache &cache, ModelPrefetcher *prefetcher) : cache_(cache), prefetcher_(prefetcher) {
+  const DefaultThreadPolicyScope default_policy;
+  worker_ = std::thread(&ModelLoader::run_loop, this);
+}
+
+ModelLoader::~ModelLoader() {
+  {
+    std::scoped_lock lock(mutex_);
+    stopping_ = true;
+    requested_.reset();
+  }
+  cv_.notify_all();
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+}
+
+uint64_t ModelLoader::request(const std::filesystem::path &path) {
+  // Reads the file alongside april-asr, in large blocks, so its own smaller
+  // reads mostly hit the page cache.
+  if (prefetcher_ && !cache_.contains(path)) {
+    prefetcher_->prefetch(path);
+  }
+  uint64_t generation = 0;
+  {
+    std::scoped_lock lock(mutex_);
+    generation = ++generation_;
+    requested_ = path;
+    pending_ = path;
+    ready_.reset();
+  }
+  cv_.notify_all();
+  return generation;
+}
+
+void ModelLoader::cancel() {
+  std::scoped_lock lock(mutex_);
+  ++generation_;
+  requested_.reset();
+  pending_.reset();
+  ready_.reset();
+}
+
+std::optional<ModelLoader::Ready> ModelLoader::poll() {
+  std::scoped_lock lock(mutex_);
+  std::optional<Ready> out;
+  out.swap(ready_);
+  return out;
+}
+
+std::optional<std::filesystem::path> ModelLoader::pending() const {
+  std::scoped_lock lock(mutex_);
+  return pending_;
+}
+
+void ModelLoader::run_loop() {
+  std::unique_lock lock(mutex_);
+  while (true) {
+    cv_.wait(lock, [&] { return stopping_ || requested_.has_value(); });
+    if (stopping_) {
+      return;
+    }
+    const uint64_t generation = generation_;
+    const std::filesystem::path path = *requested_;
+    requested_.reset();
+    lock.unlock();
+
+    const auto started = std::chrono::steady_clock::now();
+    const uint64_t hits_before = cache_.stats().hits;
+    auto model = cache_.get(path);
+    Ready ready;
+    ready.generation = generation;
+    ready.path = path;
+    ready.model = std::move(model);
+    ready.cache_hit = cache_.stats().hits > hits_before;
+    ready.wait_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+
+    lock.lock();
+    // Superseded or cancelled meanwhile.
+    if (generation == generation_) {
+      ready_ = std::move(ready);
+      pending_.reset();
+    }
+  }
+}
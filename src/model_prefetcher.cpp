@@ -0,0 +1,197 @@
+#include "model_prefetcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "thread_policy.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+// Large reads keep the disk (or network share) busy with few round trips.
+constexpr size_t kReadBytes = 4 * 1024 * 1024;
+
+std::optional<std::pair<uint64_t, std::filesystem::file_time_type>> stamp(const std::filesystem::path &path) {
+  std::error_code ec;
+  const uint64_t bytes = std::filesystem::file_size(path, ec);
+  if (ec) {
+    return std::nullopt;
+  }
+  const auto mtime = std::filesystem::last_write_time(path, ec);
+  if (ec) {
+    return std::nullopt;
+  }
+  return std::make_pair(bytes, mtime);
+}
+}  // namespace
+
+ModelPrefetcher::ModelPrefetcher() {
+  const DefaultThreadPolicyScope default_policy;
+  worker_ = std::thread(&ModelPrefetcher::run_loop, this);
+}
+
+ModelPrefetcher::~ModelPrefetcher() {
+  {
+    std::scoped_lock lock(mutex_);
+    stopping_ = true;
+    queue_.clear();
+  }
+  interrupt_ = true;
+  cv_.notify_all();
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+}
+
+void ModelPrefetcher::prefetch(const std::filesystem::path &path) {
+  {
+    std::scoped_lock lock(mutex_);
+    if (current_ == path) {
+      return;
+    }
+    queue_.erase(std::remove(queue_.begin(), queue_.end(), path), queue_.end());
+    queue_.push_front(path);
+    // Whatever is being warmed is only a guess; it goes back in line.
+    if (current_) {
+      queue_.insert(queue_.begin() + 1, *current_);
+      interrupt_ = true;
+    }
+  }
+  cv_.notify_all();
+}
+
+void ModelPrefetcher::warm(std::vector<std::filesystem::path> paths) {
+  {
+    std::scoped_lock lock(mutex_);
+    queue_.assign(paths.begin(), paths.end());
+  }
+  cv_.notify_all();
+}
+
+void ModelPrefetcher::cancel() {
+  std::scoped_lock lock(mutex_);
+  queue_.clear();
+  if (current_) {
+    interrupt_ = true;
+  }
+}
+
+bool ModelPrefetcher::warmed(const std::filesystem::path &path) const {
+  const auto now = stamp(path);
+  std::scoped_lock lock(mutex_);
+  auto it = warmed_.find(path);
+  return now && it != warmed_.end() && it->second.bytes == now->first && it->second.mtime == now->second;
+}
+
+std::optional<std::filesystem::path> ModelPrefetcher::current() const {
+  std::scoped_lock lock(mutex_);
+  return current_;
+}
+
+ModelPrefetcher::Stats ModelPrefetcher::stats() const {
+  std::scoped_lock lock(mutex_);
+  return stats_;
+}
+
+void ModelPrefetcher::run_loop() {
+  std::unique_lock lock(mutex_);
+  while (true) {
+    cv_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+    if (stopping_) {
+      return;
+    }
+    const std::filesystem::path path = queue_.front();
+    queue_.pop_front();
+    const auto before = stamp(path);
+    if (!before) {
+      continue;
+    }
+    // Already read and unchanged.
+    auto it = warmed_.find(path);
+    if (it != warmed_.end() && it->second.bytes == before->first && it->second.mtime == before->second) {
+      continue;
+    }
+    current_ = path;
+    interrupt_ = false;
+    lock.unlock();
+
+    const auto started = std::chrono::steady_clock::now();
+    const auto bytes = read_through(path, &interrupt_);
+    const double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+
+    lock.lock();
+    current_.reset();
+    if (bytes && *bytes == before->first && !interrupt_) {
+      warmed_[path] = FileStamp{before->first, before->second};
+      ++stats_.files;
+      stats_.bytes += *bytes;
+      stats_.last_path = path;
+      stats_.last_ms = elapsed_ms;
+      stats_.last_bytes = *bytes;
+    }
+  }
+}
+
+std::optional<uint64_t> ModelPrefetcher::read_through(const std::filesystem::path &path, const std::atomic<bool> *abort) {
+  std::vector<char> buffer(kReadBytes);
+  uint64_t total = 0;
+  auto aborted = [&]() { return abort && abort->load(std::memory_order_relaxed); };
+#if defined(_WIN32)
+  HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return std::nullopt;
+  }
+  DWORD got = 0;
+  while (!aborted() && ReadFile(file, buffer.data(), static_cast<DWORD>(buffer.size()), &got, nullptr) && got > 0) {
+    total += got;
+  }
+  CloseHandle(file);
+#else
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return std::nullopt;
+  }
+#if defined(__linux__)
+  // Queues readahead of the whole file; the reads below then mostly wait on
+  // I/O already in flight.
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+#elif defined(__APPLE__)
+  fcntl(fd, F_RDAHEAD, 1);
+#endif
+  while (!aborted()) {
+    const ssize_t got = ::read(fd, buffer.data(), buffer.size());
+    if (got <= 0) {
+      break;
+    }
+    total += static_cast<uint64_t>(got);
+  }
+  ::close(fd);
+#endif
+  return total;
+}
+
+bool ModelPrefetcher::evict(const std::filesystem::path &path) {
+#if defined(__linux__)
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  const bool ok = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+  ::close(fd);
+  return ok;
+#else
+  (void)path;
+  return false;
+#endif
+}
@@ -0,0 +1,275 @@
+#include "offline_transcriber.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "downmix.h"
+#include "pcm_convert.h"
+#include "wav_reader.h"
+
+namespace {
+// Large blocks keep per-call overhead negligible; progress is reported per block.
+constexpr double kBlockSeconds = 1.0;
+// Each cut costs the recognizer its context, so chunks stay long.
+constexpr double kMinChunkSeconds = 60.0;
+// More chunks than workers lets the last ones even out the finish.
+constexpr unsigned kChunksPerJob = 3;
+// How far a cut may move from its even split to land in a pause.
+constexpr double kSearchSeconds = 15.0;
+constexpr double kHopSeconds = 0.01;
+constexpr double kQuietSeconds = 0.4;
+
+struct Chunk {
+  uint64_t begin = 0;
+  uint64_t end = 0;
+};
+
+// Splits the file into roughly equal chunks, moving each cut to the quietest
+// stretch near it so no word is split. Costs one extra read of the file.
+std::vector<Chunk> plan_chunks(WavReader &reader, unsigned jobs) {
+  const uint64_t total = reader.frames();
+  const double seconds = static_cast<double>(total) / reader.rate();
+  const size_t count = std::min<size_t>(static_cast<size_t>(jobs) * kChunksPerJob,
+                                        static_cast<size_t>(seconds / kMinChunkSeconds));
+  if (jobs <= 1 || count <= 1) {
+    return {Chunk{0, total}};
+  }
+
+  // Mean square per 10 ms hop.
+  const size_t hop = std::max<size_t>(1, static_cast<size_t>(reader.rate() * kHopSeconds));
+  std::vector<float> energy;
+  energy.reserve(static_cast<size_t>(total / hop) + 1);
+  std::vector<float> block(hop * reader.channels());
+  reader.seek(0);
+  while (const size_t frames = reader.read(block.data(), hop)) {
+    double sum = 0.0;
+    for (size_t i = 0; i < frames * reader.channels(); ++i) {
+      sum += static_cast<double>(block[i]) * block[i];
+    }
+    energy.push_back(static_cast<float>(sum / static_cast<double>(frames * reader.channels())));
+  }
+  reader.seek(0);
+
+  const size_t hops = energy.size();
+  const size_t quiet = std::max<size_t>(1, static_cast<size_t>(kQuietSeconds / kHopSeconds));
+  const size_t reach = std::min(hops / count / 4, static_cast<size_t>(kSearchSeconds / kHopSeconds));
+  std::vector<Chunk> chunks;
+  uint64_t begin = 0;
+  for (size_t i = 1; i < count; ++i) {
+    const size_t ideal = hops * i / count;
+    const size_t lo = std::max(ideal - std::min(ideal, reach), static_cast<size_t>(begin / hop) + quiet);
+    const size_t hi = std::min(ideal + reach, hops - quiet);
+    if (lo >= hi) {
+      continue;
+    }
+    // Sliding sum over `quiet` hops; the cut goes in the middle of the quietest window.
+    double sum = 0.0;
+    for (size_t h = lo; h < lo + quiet; ++h) {
+      sum += energy[h];
+    }
+    double best = sum;
+    size_t best_start = lo;
+    for (size_t h = lo + 1; h <= hi; ++h) {
+      sum += energy[h + quiet - 1] - energy[h - 1];
+      if (sum < best) {
+        best = sum;
+        best_start = h;
+      }
+    }
+    const uint64_t cut = static_cast<uint64_t>(best_start + quiet / 2) * hop;
+    chunks.push_back(Chunk{begin, cut});
+    begin = cut;
+  }
+  chunks.push_back(Chunk{begin, total});
+  return chunks;
+}
+
+// Strips the leading space tokens carry and appends non-empty finals to `out`,
+// shifted by the chunk's position in the file.
+void drain(AprilAsrEngine &engine, size_t offset_ms, std::vector<AprilAsrEngine::TimedText> &out) {
+  while (auto timed = engine.poll_timed_text()) {
+    const size_t first = timed->text.find_first_not_of(' ');
+    if (first == std::string::npos) {
+      continue;
+    }
+    timed->text.erase(0, first);
+    timed->start_ms += offset_ms;
+    timed->end_ms += offset_ms;
+    out.push_back(std::move(*timed));
+  }
+}
+}  // namespace
+
+bool OfflineTranscriber::run(const std::shared_ptr<AprilModel> &model, const std::filesystem::path &path,
+                             const Options &options, const SegmentHandler &on_segment, Result &result,
+                             std::string &error) {
+  result = Result{};
+  if (!model) {
+    error = "no model";
+    return false;
+  }
+  WavReader probe;
+  if (!probe.open(path, error)) {
+    return false;
+  }
+  const size_t model_rate = model->sample_rate();
+  const uint32_t file_rate = probe.rate();
+  const uint32_t channels = probe.channels();
+  {
+    Downmixer downmix;
+    Resampler resampler;
+    if (!downmix.configure(channels) || !resampler.configure(file_rate, model_rate, options.resample_quality)) {
+      error = "cannot convert " + std::to_string(file_rate) + " Hz x " + std::to_string(channels) + " ch to " +
+              std::to_string(model_rate) + " Hz";
+      return false;
+    }
+  }
+
+  const auto started = std::chrono::steady_clock::now();
+  unsigned jobs = options.jobs != 0 ? options.jobs : std::max(1u, std::thread::hardware_concurrency());
+  const std::vector<Chunk> chunks = plan_chunks(probe, jobs);
+  const uint64_t total_frames = probe.frames();
+  probe.close();
+  jobs = static_cast<unsigned>(std::min<size_t>(jobs, chunks.size()));
+
+  std::atomic<size_t> next_chunk{0};
+  std::atomic<uint64_t> fed{0};
+  std::atomic<bool> failed{false};
+  auto cancelled = [&]() {
+    return failed.load(std::memory_order_relaxed) || (options.cancel && options.cancel->load(std::memory_order_relaxed));
+  };
+
+  // Finished chunks wait here until every earlier one is out.
+  std::mutex emit_mutex;
+  std::vector<std::vector<AprilAsrEngine::TimedText>> finished(chunks.size());
+  std::vector<bool> done(chunks.size(), false);
+  size_t next_emit = 0;
+  uint64_t decoded_frames = 0;
+
+  auto worker = [&]() {
+    WavReader reader;
+    std::string open_error;
+    if (!reader.open(path, open_error)) {
+      std::scoped_lock lock(emit_mutex);
+      error = open_error;
+      failed = true;
+      return;
+    }
+    AprilAsrEngine engine;
+    Downmixer downmix;
+    Resampler resampler;
+    downmix.configure(channels);
+    resampler.configure(file_rate, model_rate, options.resample_quality);
+    const size_t block = static_cast<size_t>(file_rate * kBlockSeconds);
+    // Mono 16-bit at the model rate goes to the engine untouched.
+    const bool direct = reader.encoding() == WavReader::Encoding::Pcm16 && channels == 1 && file_rate == model_rate;
+    std::vector<float> interleaved(direct ? 0 : block * channels);
+    std::vector<float> mono(direct ? 0 : block);
+    std::vector<float> resampled;
+    std::vector<short> pcm16(block * model_rate / file_rate + 2);
+    resampler.reserve(block);
+
+    while (!cancelled()) {
+      const size_t index = next_chunk.fetch_add(1);
+      if (index >= chunks.size()) {
+        break;
+      }
+      const Chunk chunk = chunks[index];
+      const size_t offset_ms = static_cast<size_t>(chunk.begin * 1000 / file_rate);
+      std::vector<AprilAsrEngine::TimedText> segments;
+      // Later chunks only need a new session on the model already set.
+      const bool ready = engine.has_session() ? engine.restart_session(false)
+                                              : engine.set_model(model) && engine.start(AprilAsrEngine::Mode::Synchronous);
+      if (!ready) {
+        std::scoped_lock lock(emit_mutex);
+        error = "cannot create a session";
+        failed = true;
+        break;
+      }
+      resampler.reset();
+      reader.seek(chunk.begin);
+      while (reader.position() < chunk.end && !cancelled()) {
+        const size_t want = static_cast<size_t>(std::min<uint64_t>(block, chunk.end - reader.position()));
+        size_t frames = 0;
+        size_t samples = 0;
+        if (direct) {
+          frames = reader.read_pcm16(pcm16.data(), want);
+          samples = frames;
+        } else {
+          frames = reader.read(interleaved.data(), want);
+          downmix.process(interleaved.data(), frames, mono.data());
+          std::span<const float> out(mono.data(), frames);
+          if (!resampler.passthrough()) {
+            resampler.process(out, resampled);
+            out = resampled;
+          }
+          float_to_pcm16(out.data(), pcm16.data(), out.size());
+          samples = out.size();
+        }
+        if (frames == 0) {
+          break;
+        }
+        engine.push_pcm16(std::span<const short>(pcm16.data(), samples));
+        fed.fetch_add(samples, std::memory_order_relaxed);
+        drain(engine, offset_ms, segments);
+        if (options.on_progress) {
+          std::scoped_lock lock(emit_mutex);
+          decoded_frames += frames;
+          options.on_progress(static_cast<double>(decoded_frames) / static_cast<double>(std::max<uint64_t>(1, total_frames)));
+        }
+      }
+      engine.flush();
+      drain(engine, offset_ms, segments);
+
+      std::scoped_lock lock(emit_mutex);
+      finished[index] = std::move(segments);
+      done[index] = true;
+      while (next_emit < chunks.size() && done[next_emit]) {
+        for (const auto &segment : finished[next_emit]) {
+          ++result.segments;
+          if (on_segment) {
+            on_segment(segment);
+          }
+        }
+        finished[next_emit].clear();
+        ++next_emit;
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned i = 1; i < jobs; ++i) {
+    workers.emplace_back(worker);
+  }
+  worker();
+  for (auto &thread : workers) {
+    thread.join();
+  }
+
+  result.audio_seconds = static_cast<double>(fed.load()) / static_cast<double>(model_rate);
+  result.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+  result.chunks = chunks.size();
+  result.jobs = jobs;
+  if (failed) {
+    return false;
+  }
+  if (options.cancel && options.cancel->load(std::memory_order_relaxed)) {
+    error = "cancelled";
+    return false;
+  }
+  return true;
+}
+
+std::string format_offset_ms(size_t ms) {
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%02zu:%02zu:%02zu.%03zu", ms / 3600000, ms / 60000 % 60, ms / 1000 % 60, ms % 1000);
+  return buf;
+}
+
+std::string format_segment(const AprilAsrEngine::TimedText &segment) {
+  return "[" + format_offset_ms(segment.start_ms) + " --> " + format_offset_ms(segment.end_ms) + "] " + segment.text;
+}
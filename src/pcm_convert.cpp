@@ -0,0 +1,211 @@
+#include "pcm_convert.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "cpu_features.h"
+
+#if defined(SIMD_X86)
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+using ConvertFn = void (*)(const float *, short *, size_t);
+using MixFn = void (*)(const short *, float, const short *, float, short *, size_t);
+
+struct Kernel {
+  ConvertFn fn;
+  MixFn mix;
+  const char *name;
+};
+
+constexpr float kPcmMin = -32768.0f;
+constexpr float kPcmMax = 32767.0f;
+
+#if defined(SIMD_X86)
+void convert_sse2(const float *in, short *out, size_t count) {
+  const __m128 lo = _mm_set1_ps(-1.0f);
+  const __m128 hi = _mm_set1_ps(1.0f);
+  const __m128 scale = _mm_set1_ps(32767.0f);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128 a = _mm_loadu_ps(in + i);
+    __m128 b = _mm_loadu_ps(in + i + 4);
+    a = _mm_and_ps(a, _mm_cmpord_ps(a, a));
+    b = _mm_and_ps(b, _mm_cmpord_ps(b, b));
+    a = _mm_mul_ps(_mm_min_ps(_mm_max_ps(a, lo), hi), scale);
+    b = _mm_mul_ps(_mm_min_ps(_mm_max_ps(b, lo), hi), scale);
+    __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), packed);
+  }
+  float_to_pcm16_scalar(in + i, out + i, count - i);
+}
+
+void mix_sse2(const short *a, float gain_a, const short *b, float gain_b, short *out, size_t count) {
+  const __m128 ga = _mm_set1_ps(gain_a);
+  const __m128 gb = _mm_set1_ps(gain_b);
+  const __m128 lo = _mm_set1_ps(kPcmMin);
+  const __m128 hi = _mm_set1_ps(kPcmMax);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+    const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+    // Sign-extend to 32 bits by unpacking into the high half and shifting down.
+    const __m128 a_lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(va, va), 16));
+    const __m128 a_hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(va, va), 16));
+    const __m128 b_lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(vb, vb), 16));
+    const __m128 b_hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(vb, vb), 16));
+    __m128 m_lo = _mm_add_ps(_mm_mul_ps(a_lo, ga), _mm_mul_ps(b_lo, gb));
+    __m128 m_hi = _mm_add_ps(_mm_mul_ps(a_hi, ga), _mm_mul_ps(b_hi, gb));
+    m_lo = _mm_min_ps(_mm_max_ps(m_lo, lo), hi);
+    m_hi = _mm_min_ps(_mm_max_ps(m_hi, lo), hi);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packs_epi32(_mm_cvtps_epi32(m_lo), _mm_cvtps_epi32(m_hi)));
+  }
+  mix_pcm16_scalar(a + i, gain_a, b + i, gain_b, out + i, count - i);
+}
+
+#if defined(SIMD_AVX2)
+SIMD_TARGET_AVX2 void convert_avx2(const float *in, short *out, size_t count) {
+  const __m256 lo = _mm256_set1_ps(-1.0f);
+  const __m256 hi = _mm256_set1_ps(1.0f);
+  const __m256 scale = _mm256_set1_ps(32767.0f);
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m256 a = _mm256_loadu_ps(in + i);
+    __m256 b = _mm256_loadu_ps(in + i + 8);
+    a = _mm256_and_ps(a, _mm256_cmp_ps(a, a, _CMP_ORD_Q));
+    b = _mm256_and_ps(b, _mm256_cmp_ps(b, b, _CMP_ORD_Q));
+    a = _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(a, lo), hi), scale);
+    b = _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(b, lo), hi), scale);
+    // packs works per 128-bit lane; restore sample order afterwards.
+    __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+    packed = _mm256_permute4x64_epi64(packed, 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), packed);
+  }
+  convert_sse2(in + i, out + i, count - i);
+}
+
+// AVX2 without FMA, so the compiler cannot fuse the multiply-add below back
+// together.
+__attribute__((target("avx2"))) void mix_avx2(const short *a, float gain_a, const short *b, float gain_b, short *out, size_t count) {
+  const __m256 ga = _mm256_set1_ps(gain_a);
+  const __m256 gb = _mm256_set1_ps(gain_b);
+  const __m256 lo = _mm256_set1_ps(kPcmMin);
+  const __m256 hi = _mm256_set1_ps(kPcmMax);
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    const __m128i *pa = reinterpret_cast<const __m128i *>(a + i);
+    const __m128i *pb = reinterpret_cast<const __m128i *>(b + i);
+    const __m256 a0 = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(pa)));
+    const __m256 a1 = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(pa + 1)));
+    const __m256 b0 = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(pb)));
+    const __m256 b1 = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(pb + 1)));
+    // A fused multiply-add rounds once less than the scalar path and can
+    // land one LSB away from it.
+    __m256 m0 = _mm256_add_ps(_mm256_mul_ps(a0, ga), _mm256_mul_ps(b0, gb));
+    __m256 m1 = _mm256_add_ps(_mm256_mul_ps(a1, ga), _mm256_mul_ps(b1, gb));
+    m0 = _mm256_min_ps(_mm256_max_ps(m0, lo), hi);
+    m1 = _mm256_min_ps(_mm256_max_ps(m1, lo), hi);
+    __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(m0), _mm256_cvtps_epi32(m1));
+    packed = _mm256_permute4x64_epi64(packed, 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), packed);
+  }
+  mix_sse2(a + i, gain_a, b + i, gain_b, out + i, count - i);
+}
+#endif
+#elif defined(SIMD_NEON)
+void convert_neon(const float *in, short *out, size_t count) {
+  const float32x4_t lo = vdupq_n_f32(-1.0f);
+  const float32x4_t hi = vdupq_n_f32(1.0f);
+  const float32x4_t scale = vdupq_n_f32(32767.0f);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    float32x4_t a = vld1q_f32(in + i);
+    float32x4_t b = vld1q_f32(in + i + 4);
+    // NaN propagates through min/max and vcvtnq converts it to 0, matching
+    // the scalar path's explicit NaN check (lrintf itself is unspecified for
+    // NaN).
+    a = vmulq_f32(vminq_f32(vmaxq_f32(a, lo), hi), scale);
+    b = vmulq_f32(vminq_f32(vmaxq_f32(b, lo), hi), scale);
+    int16x8_t packed = vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(a)), vqmovn_s32(vcvtnq_s32_f32(b)));
+    vst1q_s16(out + i, packed);
+  }
+  float_to_pcm16_scalar(in + i, out + i, count - i);
+}
+
+void mix_neon(const short *a, float gain_a, const short *b, float gain_b, short *out, size_t count) {
+  const float32x4_t ga = vdupq_n_f32(gain_a);
+  const float32x4_t gb = vdupq_n_f32(gain_b);
+  const float32x4_t lo = vdupq_n_f32(kPcmMin);
+  const float32x4_t hi = vdupq_n_f32(kPcmMax);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const int16x8_t va = vld1q_s16(a + i);
+    const int16x8_t vb = vld1q_s16(b + i);
+    const float32x4_t a_lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(va)));
+    const float32x4_t a_hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(va)));
+    const float32x4_t b_lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(vb)));
+    const float32x4_t b_hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(vb)));
+    float32x4_t m_lo = vaddq_f32(vmulq_f32(a_lo, ga), vmulq_f32(b_lo, gb));
+    float32x4_t m_hi = vaddq_f32(vmulq_f32(a_hi, ga), vmulq_f32(b_hi, gb));
+    m_lo = vminq_f32(vmaxq_f32(m_lo, lo), hi);
+    m_hi = vminq_f32(vmaxq_f32(m_hi, lo), hi);
+    vst1q_s16(out + i, vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(m_lo)), vqmovn_s32(vcvtnq_s32_f32(m_hi))));
+  }
+  mix_pcm16_scalar(a + i, gain_a, b + i, gain_b, out + i, count - i);
+}
+#endif
+
+Kernel select_kernel() {
+  const auto &cpu = cpu_features();
+  (void)cpu;
+#if defined(SIMD_X86)
+#if defined(SIMD_AVX2)
+  if (cpu.avx2) {
+    return {&convert_avx2, &mix_avx2, "avx2"};
+  }
+#endif
+  if (cpu.sse2) {
+    return {&convert_sse2, &mix_sse2, "sse2"};
+  }
+#elif defined(SIMD_NEON)
+  if (cpu.neon) {
+    return {&convert_neon, &mix_neon, "neon"};
+  }
+#endif
+  return {&float_to_pcm16_scalar, &mix_pcm16_scalar, "scalar"};
+}
+
+const Kernel &kernel() {
+  static const Kernel k = select_kernel();
+  return k;
+}
+}  // namespace
+
+void float_to_pcm16_scalar(const float *in, short *out, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    float clamped = std::clamp(in[i], -1.0f, 1.0f);
+    out[i] = std::isnan(clamped) ? 0 : static_cast<short>(std::lrintf(clamped * 32767.0f));
+  }
+}
+
+void float_to_pcm16(const float *in, short *out, size_t count) {
+  kernel().fn(in, out, count);
+}
+
+void mix_pcm16_scalar(const short *a, float gain_a, const short *b, float gain_b, short *out, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    const float mixed = static_cast<float>(a[i]) * gain_a + static_cast<float>(b[i]) * gain_b;
+    out[i] = static_cast<short>(std::lrintf(std::clamp(mixed, kPcmMin, kPcmMax)));
+  }
+}
+
+void mix_pcm16(const short *a, float gain_a, const short *b, float gain_b, short *out, size_t count) {
+  kernel().mix(a, gain_a, b, gain_b, out, count);
+}
+
+const char *pcm_convert_kernel_name() {
+  return kernel().name;
+}
@@ -0,0 +1,86 @@
+#include "qos_controller.h"
+
+#include <cstdio>
+
+namespace {
+// Weight of a new sample; about five samples to settle.
+constexpr float kSmoothing = 0.3f;
+
+QosController::Level step(QosController::Level level, int delta) {
+  return static_cast<QosController::Level>(static_cast<int>(level) + delta);
+}
+}  // namespace
+
+std::optional<QosController::Decision> QosController::update(float speedup, uint64_t cant_keep_up,
+                                                             std::chrono::steady_clock::time_point now) {
+  const uint64_t new_errors = last_errors_ && cant_keep_up >= *last_errors_ ? cant_keep_up - *last_errors_ : 0;
+  last_errors_ = cant_keep_up;
+  smoothed_ = smoothed_ > 0.0f ? smoothed_ + (speedup - smoothed_) * kSmoothing : speedup;
+
+  const bool overloaded = new_errors > 0 || smoothed_ > config_.overload_speedup;
+  const bool healthy = new_errors == 0 && smoothed_ <= config_.healthy_speedup;
+  char reason[128];
+
+  if (overloaded) {
+    healthy_since_.reset();
+    if (!overloaded_since_) {
+      overloaded_since_ = now;
+      overload_errors_ = 0;
+    }
+    overload_errors_ += new_errors;
+    if (level_ >= max_level_ || now - *overloaded_since_ < config_.escalate_after) {
+      return std::nullopt;
+    }
+    std::snprintf(reason, sizeof(reason), "speedup x%.2f, %llu keep-up errors over %.0f s", smoothed_,
+                  static_cast<unsigned long long>(overload_errors_),
+                  std::chrono::duration<double>(now - *overloaded_since_).count());
+    // The next step has to prove itself insufficient all over again.
+    overloaded_since_ = now;
+    overload_errors_ = 0;
+    Decision decision{level_, step(level_, 1), reason};
+    level_ = decision.to;
+    return decision;
+  }
+
+  overloaded_since_.reset();
+  if (!healthy) {
+    // Between the thresholds: neither worse nor clearly better.
+    healthy_since_.reset();
+    return std::nullopt;
+  }
+  if (!healthy_since_) {
+    healthy_since_ = now;
+  }
+  if (level_ == Level::Normal || now - *healthy_since_ < config_.recover_after) {
+    return std::nullopt;
+  }
+  std::snprintf(reason, sizeof(reason), "speedup x%.2f, no keep-up errors for %.0f s", smoothed_,
+                std::chrono::duration<double>(now - *healthy_since_).count());
+  healthy_since_ = now;
+  Decision decision{level_, step(level_, -1), reason};
+  level_ = decision.to;
+  return decision;
+}
+
+void QosController::reset(Level level) {
+  level_ = level;
+  smoothed_ = 0.0f;
+  last_errors_.reset();
+  overload_errors_ = 0;
+  overloaded_since_.reset();
+  healthy_since_.reset();
+}
+
+const char *QosController::name(Level level) {
+  switch (level) {
+  case Level::Normal:
+    return "Normal";
+  case Level::ReducedUi:
+    return "Reduced UI frame rate";
+  case Level::SkipSilence:
+    return "Skipping silence";
+  case Level::LighterModel:
+    return "Lighter model";
+  }
+  return "";
+}
@@ -0,0 +1,225 @@
+#include "resampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <numeric>
+
+#include "cpu_features.h"
+
+#if defined(SIMD_X86)
+#include <immintrin.h>
+#elif defined(SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+// Larger ratios would need an impractically large coefficient table.
+constexpr size_t kMaxPhases = 4096;
+
+struct QualityParams {
+  size_t taps;
+  double rolloff;
+  double kaiser_beta;
+};
+
+QualityParams params_for(Resampler::Quality quality) {
+  switch (quality) {
+  case Resampler::Quality::Fast:
+    return {16, 0.85, 6.0};
+  case Resampler::Quality::High:
+    return {64, 0.95, 10.0};
+  case Resampler::Quality::Balanced:
+  default:
+    return {32, 0.90, 8.6};
+  }
+}
+
+double bessel_i0(double x) {
+  double sum = 1.0;
+  double term = 1.0;
+  const double half = x * 0.5;
+  for (int k = 1; k < 64; ++k) {
+    term *= (half / k) * (half / k);
+    sum += term;
+    if (term < sum * 1e-12) {
+      break;
+    }
+  }
+  return sum;
+}
+
+float dot_scalar(const float *a, const float *b, size_t n) {
+  float sum = 0.0f;
+  for (size_t i = 0; i < n; ++i) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+// Tap counts are always multiples of 8, so the vector loops need no tail.
+#if defined(SIMD_X86)
+float dot_sse2(const float *a, const float *b, size_t n) {
+  __m128 acc0 = _mm_setzero_ps();
+  __m128 acc1 = _mm_setzero_ps();
+  for (size_t i = 0; i < n; i += 8) {
+    acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+  }
+  __m128 acc = _mm_add_ps(acc0, acc1);
+  __m128 shuf = _mm_shuffle_ps(acc, acc, _MM_SHUFFLE(2, 3, 0, 1));
+  __m128 sums = _mm_add_ps(acc, shuf);
+  shuf = _mm_movehl_ps(shuf, sums);
+  return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+}
+
+#if defined(SIMD_AVX2)
+SIMD_TARGET_AVX2 float dot_avx2(const float *a, const float *b, size_t n) {
+  __m256 acc = _mm256_setzero_ps();
+  for (size_t i = 0; i < n; i += 8) {
+    acc = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc);
+  }
+  __m128 lo = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+  __m128 shuf = _mm_shuffle_ps(lo, lo, _MM_SHUFFLE(2, 3, 0, 1));
+  __m128 sums = _mm_add_ps(lo, shuf);
+  shuf = _mm_movehl_ps(shuf, sums);
+  return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+}
+#endif
+#elif defined(SIMD_NEON)
+float dot_neon(const float *a, const float *b, size_t n) {
+  float32x4_t acc0 = vdupq_n_f32(0.0f);
+  float32x4_t acc1 = vdupq_n_f32(0.0f);
+  for (size_t i = 0; i < n; i += 8) {
+    acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+    acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+  }
+  return vaddvq_f32(vaddq_f32(acc0, acc1));
+}
+#endif
+
+using DotFn = float (*)(const float *, const float *, size_t);
+
+DotFn select_dot() {
+#if defined(SIMD_X86)
+#if defined(SIMD_AVX2)
+  if (cpu_features().avx2) {
+    return &dot_avx2;
+  }
+#endif
+  if (cpu_features().sse2) {
+    return &dot_sse2;
+  }
+#elif defined(SIMD_NEON)
+  return &dot_neon;
+#endif
+  return &dot_scalar;
+}
+
+DotFn dot() {
+  static const DotFn fn = select_dot();
+  return fn;
+}
+}  // namespace
+
+bool Resampler::configure(size_t in_rate, size_t out_rate, Quality quality) {
+  if (in_rate == 0 || out_rate == 0) {
+    return false;
+  }
+  const size_t g = std::gcd(in_rate, out_rate);
+  const size_t up = out_rate / g;
+  const size_t down = in_rate / g;
+  if (up > kMaxPhases) {
+    return false;
+  }
+
+  in_rate_ = in_rate;
+  out_rate_ = out_rate;
+  up_ = up;
+  down_ = down;
+  coeffs_.clear();
+  if (passthrough()) {
+    taps_ = 0;
+    buffer_.clear();
+    pos_ = 0;
+    return true;
+  }
+
+  // Widen the filter when decimating so the transition band stays put
+  // relative to the output Nyquist frequency.
+  const QualityParams p = params_for(quality);
+  const size_t ratio = (down_ + up_ - 1) / up_;
+  taps_ = p.taps * std::max<size_t>(1, ratio);
+
+  const size_t length = taps_ * up_;
+  const double center = (static_cast<double>(length) - 1.0) * 0.5;
+  const double cutoff = 0.5 * p.rolloff / static_cast<double>(std::max(up_, down_));
+  const double i0_beta = bessel_i0(p.kaiser_beta);
+  std::vector<double> prototype(length);
+  for (size_t n = 0; n < length; ++n) {
+    const double t = static_cast<double>(n) - center;
+    const double x = 2.0 * cutoff * t;
+    const double sinc = std::abs(x) < 1e-12 ? 1.0 : std::sin(std::numbers::pi * x) / (std::numbers::pi * x);
+    const double r = t / (center + 0.5);
+    const double window = bessel_i0(p.kaiser_beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / i0_beta;
+    prototype[n] = 2.0 * cutoff * sinc * window;
+  }
+
+  coeffs_.assign(up_ * taps_, 0.0f);
+  for (size_t phase = 0; phase < up_; ++phase) {
+    float *row = &coeffs_[phase * taps_];
+    double sum = 0.0;
+    for (size_t q = 0; q < taps_; ++q) {
+      sum += prototype[phase + (taps_ - 1 - q) * up_];
+    }
+    // Normalize every branch to unity DC gain.
+    const double gain = sum != 0.0 ? 1.0 / sum : 0.0;
+    for (size_t q = 0; q < taps_; ++q) {
+      row[q] = static_cast<float>(prototype[phase + (taps_ - 1 - q) * up_] * gain);
+    }
+  }
+  reset();
+  return true;
+}
+
+void Resampler::reserve(size_t max_in_frames) {
+  buffer_.reserve(taps_ + max_in_frames);
+}
+
+void Resampler::reset() {
+  if (passthrough()) {
+    return;
+  }
+  buffer_.assign(taps_ - 1, 0.0f);
+  pos_ = (taps_ - 1) * up_;
+}
+
+void Resampler::process(std::span<const float> in, std::vector<float> &out) {
+  if (passthrough()) {
+    out.assign(in.begin(), in.end());
+    return;
+  }
+  if (coeffs_.empty()) {
+    out.clear();
+    return;
+  }
+
+  buffer_.insert(buffer_.end(), in.begin(), in.end());
+  const size_t limit = buffer_.size() * up_;
+  const size_t produced = pos_ < limit ? (limit - pos_ + down_ - 1) / down_ : 0;
+  out.resize(produced);
+
+  const DotFn fn = dot();
+  const float *coeffs = coeffs_.data();
+  for (size_t k = 0; k < produced; ++k) {
+    const size_t idx = pos_ / up_;
+    const size_t phase = pos_ % up_;
+    out[k] = fn(coeffs + phase * taps_, buffer_.data() + idx + 1 - taps_, taps_);
+    pos_ += down_;
+  }
+
+  // Keep only the history the next call's first output needs.
+  const size_t drop = buffer_.size() - (taps_ - 1);
+  buffer_.erase(buffer_.begin(), buffer_.begin() + static_cast<std::ptrdiff_t>(drop));
+  pos_ -= drop * up_;
+}
@@ -0,0 +1,330 @@
+#include "thread_policy.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#endif
+
+namespace {
+constexpr int kDefaultNice = -5;
+constexpr int kDefaultRealtimePriority = 10;
+
+bool parse_int(std::string_view text, int &out) {
+  if (!text.empty() && text.front() == '+') {
+    text.remove_prefix(1);
+  }
+  auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+  return ec == std::errc() && ptr == text.data() + text.size();
+}
+
+bool parse_cpus(std::string_view text, std::vector<int> &out) {
+  out.clear();
+  while (!text.empty()) {
+    const size_t comma = text.find(',');
+    std::string_view item = text.substr(0, comma);
+    text = comma == std::string_view::npos ? std::string_view() : text.substr(comma + 1);
+    const size_t dash = item.find('-');
+    int first = 0;
+    int last = 0;
+    if (dash == std::string_view::npos) {
+      if (!parse_int(item, first)) {
+        return false;
+      }
+      last = first;
+    } else if (!parse_int(item.substr(0, dash), first) || !parse_int(item.substr(dash + 1), last)) {
+      return false;
+    }
+    if (first < 0 || last < first || last > 1023) {
+      return false;
+    }
+    for (int cpu = first; cpu <= last; ++cpu) {
+      out.push_back(cpu);
+    }
+  }
+  std::sort(out.begin(), out.end());
+  out.erase(std::unique(out.begin(), out.end()), out.end());
+  return !out.empty();
+}
+
+const char *scheduler_name(ThreadPolicy::Scheduler scheduler) {
+  switch (scheduler) {
+  case ThreadPolicy::Scheduler::Nice:
+    return "nice";
+  case ThreadPolicy::Scheduler::Fifo:
+    return "fifo";
+  case ThreadPolicy::Scheduler::RoundRobin:
+    return "rr";
+  default:
+    return "default";
+  }
+}
+
+#if !defined(_WIN32)
+// What "default" means for each part: the calling thread's state the first
+// time a policy is applied, which is before that policy changes anything.
+struct Baseline {
+  int sched = SCHED_OTHER;
+  sched_param param{};
+  int nice = 0;
+#if defined(__linux__)
+  cpu_set_t cpus{};
+  bool have_cpus = false;
+#endif
+};
+
+int current_nice() {
+#if defined(__linux__)
+  errno = 0;
+  const int nice = getpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)));
+  return errno == 0 ? nice : 0;
+#else
+  return 0;
+#endif
+}
+
+const Baseline &baseline() {
+  static const Baseline saved = [] {
+    Baseline b;
+    if (pthread_getschedparam(pthread_self(), &b.sched, &b.param) != 0) {
+      b.sched = SCHED_OTHER;
+      b.param = sched_param{};
+    }
+    b.nice = current_nice();
+#if defined(__linux__)
+    b.have_cpus = pthread_getaffinity_np(pthread_self(), sizeof(b.cpus), &b.cpus) == 0;
+#endif
+    return b;
+  }();
+  return saved;
+}
+#endif
+
+std::string error_text(int error) {
+#if defined(_WIN32)
+  return "error " + std::to_string(error);
+#else
+  return std::strerror(error);
+#endif
+}
+}  // namespace
+
+bool parse_thread_policy(std::string_view text, ThreadPolicy &out) {
+  std::string lower(text);
+  std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+  lower.erase(std::remove_if(lower.begin(), lower.end(), [](unsigned char c) { return std::isspace(c); }), lower.end());
+  std::string_view rest(lower);
+
+  ThreadPolicy policy;
+  const size_t at = rest.find('@');
+  if (at != std::string_view::npos) {
+    if (!parse_cpus(rest.substr(at + 1), policy.cpus)) {
+      return false;
+    }
+    rest = rest.substr(0, at);
+  }
+
+  const size_t colon = rest.find(':');
+  const std::string_view name = rest.substr(0, colon);
+  if (name.empty() || name == "default") {
+    policy.scheduler = ThreadPolicy::Scheduler::Default;
+  } else if (name == "nice") {
+    policy.scheduler = ThreadPolicy::Scheduler::Nice;
+    policy.priority = kDefaultNice;
+  } else if (name == "fifo") {
+    policy.scheduler = ThreadPolicy::Scheduler::Fifo;
+    policy.priority = kDefaultRealtimePriority;
+  } else if (name == "rr") {
+    policy.scheduler = ThreadPolicy::Scheduler::RoundRobin;
+    policy.priority = kDefaultRealtimePriority;
+  } else {
+    return false;
+  }
+
+  if (colon != std::string_view::npos) {
+    if (policy.scheduler == ThreadPolicy::Scheduler::Default || !parse_int(rest.substr(colon + 1), policy.priority)) {
+      return false;
+    }
+  }
+  if (policy.scheduler == ThreadPolicy::Scheduler::Nice && (policy.priority < -20 || policy.priority > 19)) {
+    return false;
+  }
+  if ((policy.scheduler == ThreadPolicy::Scheduler::Fifo || policy.scheduler == ThreadPolicy::Scheduler::RoundRobin) &&
+      (policy.priority < 1 || policy.priority > 99)) {
+    return false;
+  }
+
+  out = std::move(policy);
+  return true;
+}
+
+std::string format_thread_policy(const ThreadPolicy &policy) {
+  std::string text = scheduler_name(policy.scheduler);
+  if (policy.scheduler != ThreadPolicy::Scheduler::Default) {
+    text += ":" + std::to_string(policy.priority);
+  }
+  for (size_t i = 0; i < policy.cpus.size(); ++i) {
+    text += (i == 0 ? "@" : ",") + std::to_string(policy.cpus[i]);
+  }
+  return text;
+}
+
+ThreadPolicyResult apply_thread_policy(const ThreadPolicy &policy) {
+  ThreadPolicyResult result;
+  result.attempted = true;
+#if !defined(_WIN32)
+  const Baseline &base = baseline();
+#endif
+
+  switch (policy.scheduler) {
+  case ThreadPolicy::Scheduler::Default: {
+    // Undoes whatever this thread inherited from the one that started it.
+#if defined(_WIN32)
+    if (!SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_NORMAL)) {
+      result.scheduler_error = static_cast<int>(GetLastError());
+    }
+#else
+    result.scheduler_error = pthread_setschedparam(pthread_self(), base.sched, &base.param);
+#if defined(__linux__)
+    if (result.scheduler_error == 0 && current_nice() != base.nice &&
+        setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), base.nice) != 0) {
+      result.scheduler_error = errno;
+    }
+#endif
+#endif
+    break;
+  }
+  case ThreadPolicy::Scheduler::Nice: {
+#if defined(_WIN32)
+    const int priority = policy.priority < 0   ? THREAD_PRIORITY_ABOVE_NORMAL
+                         : policy.priority > 0 ? THREAD_PRIORITY_BELOW_NORMAL
+                                               : THREAD_PRIORITY_NORMAL;
+    if (!SetThreadPriority(GetCurrentThread(), priority)) {
+      result.scheduler_error = static_cast<int>(GetLastError());
+    }
+#elif defined(__linux__)
+    // Linux applies nice values per thread when given a thread id, and only
+    // to the normal scheduling class.
+    result.scheduler_error = pthread_setschedparam(pthread_self(), base.sched, &base.param);
+    if (result.scheduler_error == 0 && setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), policy.priority) != 0) {
+      result.scheduler_error = errno;
+    }
+#else
+    result.scheduler_error = ENOTSUP;
+#endif
+    break;
+  }
+  case ThreadPolicy::Scheduler::Fifo:
+  case ThreadPolicy::Scheduler::RoundRobin: {
+    const bool fifo = policy.scheduler == ThreadPolicy::Scheduler::Fifo;
+#if defined(_WIN32)
+    if (!SetThreadPriority(GetCurrentThread(), fifo ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST)) {
+      result.scheduler_error = static_cast<int>(GetLastError());
+    }
+#else
+    const int sched = fifo ? SCHED_FIFO : SCHED_RR;
+    sched_param param{};
+    param.sched_priority = std::clamp(policy.priority, sched_get_priority_min(sched), sched_get_priority_max(sched));
+    result.scheduler_error = pthread_setschedparam(pthread_self(), sched, &param);
+#endif
+    break;
+  }
+  }
+
+  if (!policy.cpus.empty()) {
+#if defined(_WIN32)
+    DWORD_PTR mask = 0;
+    for (int cpu : policy.cpus) {
+      if (cpu < static_cast<int>(sizeof(DWORD_PTR) * 8)) {
+        mask |= static_cast<DWORD_PTR>(1) << cpu;
+      }
+    }
+    if (mask == 0) {
+      result.affinity_error = ERROR_INVALID_PARAMETER;
+    } else if (!SetThreadAffinityMask(GetCurrentThread(), mask)) {
+      result.affinity_error = static_cast<int>(GetLastError());
+    }
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : policy.cpus) {
+      if (cpu < CPU_SETSIZE) {
+        CPU_SET(cpu, &set);
+      }
+    }
+    result.affinity_error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    result.affinity_error = ENOTSUP;
+#endif
+  } else {
+#if defined(_WIN32)
+    DWORD_PTR process_mask = 0;
+    DWORD_PTR system_mask = 0;
+    if (GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask) &&
+        !SetThreadAffinityMask(GetCurrentThread(), process_mask)) {
+      result.affinity_error = static_cast<int>(GetLastError());
+    }
+#elif defined(__linux__)
+    if (base.have_cpus) {
+      result.affinity_error = pthread_setaffinity_np(pthread_self(), sizeof(base.cpus), &base.cpus);
+    }
+#endif
+  }
+  return result;
+}
+
+DefaultThreadPolicyScope::DefaultThreadPolicyScope() {
+#if !defined(_WIN32)
+  // Windows starts every thread at normal priority on the process's CPUs, so
+  // there is nothing to undo there.
+  if (pthread_getschedparam(pthread_self(), &sched_, &param_) != 0) {
+    sched_ = SCHED_OTHER;
+    param_ = sched_param{};
+  }
+  nice_ = current_nice();
+#if defined(__linux__)
+  have_cpus_ = pthread_getaffinity_np(pthread_self(), sizeof(cpus_), &cpus_) == 0;
+#endif
+  apply_thread_policy(ThreadPolicy{});
+#endif
+}
+
+DefaultThreadPolicyScope::~DefaultThreadPolicyScope() {
+#if !defined(_WIN32)
+  pthread_setschedparam(pthread_self(), sched_, &param_);
+#if defined(__linux__)
+  if (current_nice() != nice_) {
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), nice_);
+  }
+  if (have_cpus_) {
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus_), &cpus_);
+  }
+#endif
+#endif
+}
+
+std::string describe_thread_policy(const ThreadPolicy &policy, const ThreadPolicyResult &result) {
+  std::string text = format_thread_policy(policy);
+  if (!result.attempted) {
+    return text + " (not applied yet)";
+  }
+  if (result.scheduler_error != 0) {
+    text += std::string(" (scheduler denied: ") + error_text(result.scheduler_error) + ", kept default)";
+  }
+  if (result.affinity_error != 0) {
+    text += std::string(" (affinity denied: ") + error_text(result.affinity_error) + ", any CPU)";
+  }
+  return text;
+}
@@ -0,0 +1,193 @@
+#include "voice_gate.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr size_t kFramesPerSecond = 100;
+
+float frame_dbfs(const short *frame, size_t n) {
+  double sum = 0.0;
+  for (size_t i = 0; i < n; ++i) {
+    const double s = frame[i];
+    sum += s * s;
+  }
+  const double mean = sum / (static_cast<double>(n) * 32768.0 * 32768.0);
+  return static_cast<float>(10.0 * std::log10(mean + 1e-12));
+}
+}  // namespace
+
+void VoiceGate::configure(size_t sample_rate, const Config &config, Sink sink, PauseHandler on_pause) {
+  config_ = config;
+  sink_ = std::move(sink);
+  on_pause_ = std::move(on_pause);
+  frame_samples_ = std::max<size_t>(1, sample_rate / kFramesPerSecond);
+  hangover_frames_ = static_cast<size_t>(std::max(0, config_.hangover_ms)) * kFramesPerSecond / 1000;
+  pause_frames_ = on_pause_ ? static_cast<size_t>(std::max(0, config_.pause_ms)) * kFramesPerSecond / 1000 : 0;
+  const size_t preroll_frames = static_cast<size_t>(std::max(0, config_.preroll_ms)) * kFramesPerSecond / 1000;
+  preroll_.assign(preroll_frames * frame_samples_, 0);
+  pending_.clear();
+  pending_.reserve(frame_samples_);
+  out_.reserve(preroll_.size() + 8192);
+  processed_ = 0;
+  skipped_ = 0;
+  pauses_ = 0;
+  reset();
+}
+
+void VoiceGate::reset() {
+  pending_.clear();
+  preroll_head_ = 0;
+  preroll_fill_ = 0;
+  hang_left_ = 0;
+  silence_frames_ = 0;
+  speech_since_pause_ = false;
+  noise_init_ = false;
+  open_ = false;
+  open_flag_ = false;
+  gated_ = false;
+}
+
+void VoiceGate::process(std::span<const short> samples) {
+  if (samples.empty() || !sink_) {
+    return;
+  }
+  processed_.fetch_add(samples.size(), std::memory_order_relaxed);
+  const bool gate = gating();
+  if (gated_ && !gate) {
+    stop_gating();
+  }
+  gated_ = gate;
+  if (!gate && pause_frames_ == 0) {
+    sink_(samples);
+    return;
+  }
+
+  out_.clear();
+  size_t i = 0;
+  if (!pending_.empty()) {
+    const size_t need = std::min(frame_samples_ - pending_.size(), samples.size());
+    pending_.insert(pending_.end(), samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(need));
+    i = need;
+    if (pending_.size() == frame_samples_) {
+      process_frame(pending_.data());
+      pending_.clear();
+    }
+  }
+  for (; i + frame_samples_ <= samples.size(); i += frame_samples_) {
+    process_frame(samples.data() + i);
+  }
+  pending_.insert(pending_.end(), samples.begin() + static_cast<std::ptrdiff_t>(i), samples.end());
+  emit();
+}
+
+void VoiceGate::force_gating(bool forced) {
+  forced_.store(forced, std::memory_order_relaxed);
+}
+
+VoiceGate::Stats VoiceGate::stats() const {
+  Stats s;
+  s.processed_samples = processed_.load(std::memory_order_relaxed);
+  s.skipped_samples = skipped_.load(std::memory_order_relaxed);
+  s.pauses = pauses_.load(std::memory_order_relaxed);
+  s.open = open_flag_.load(std::memory_order_relaxed);
+  return s;
+}
+
+void VoiceGate::process_frame(const short *frame) {
+  const float db = frame_dbfs(frame, frame_samples_);
+  if (!noise_init_) {
+    noise_db_ = db;
+    noise_init_ = true;
+  }
+  const bool speech = db > std::max(noise_db_ + config_.threshold_db, config_.min_speech_dbfs);
+
+  // Follow the floor down quickly and up slowly (about 5 s), so speech
+  // itself barely lifts it.
+  const float rate = db < noise_db_ ? 0.2f : 0.002f;
+  noise_db_ += (db - noise_db_) * rate;
+
+  if (gating()) {
+    gate_frame(frame, speech);
+  } else {
+    out_.insert(out_.end(), frame, frame + frame_samples_);
+  }
+
+  if (speech) {
+    silence_frames_ = 0;
+    speech_since_pause_ = true;
+  } else if (pause_frames_ > 0 && ++silence_frames_ >= pause_frames_ && speech_since_pause_) {
+    speech_since_pause_ = false;
+    emit();
+    pauses_.fetch_add(1, std::memory_order_relaxed);
+    on_pause_();
+  }
+}
+
+void VoiceGate::gate_frame(const short *frame, bool speech) {
+  if (speech) {
+    if (!open_) {
+      open_ = true;
+      open_flag_.store(true, std::memory_order_relaxed);
+      // Replay the pre-roll, oldest first; it is no longer skipped.
+      const size_t cap = preroll_.size();
+      const size_t start = (preroll_head_ + cap - preroll_fill_) % std::max<size_t>(cap, 1);
+      for (size_t k = 0; k < preroll_fill_; ++k) {
+        out_.push_back(preroll_[(start + k) % cap]);
+      }
+      skipped_.fetch_sub(preroll_fill_, std::memory_order_relaxed);
+      preroll_fill_ = 0;
+    }
+    hang_left_ = hangover_frames_;
+    out_.insert(out_.end(), frame, frame + frame_samples_);
+    return;
+  }
+
+  if (open_ && hang_left_ > 0) {
+    --hang_left_;
+    out_.insert(out_.end(), frame, frame + frame_samples_);
+    return;
+  }
+
+  if (open_) {
+    open_ = false;
+    open_flag_.store(false, std::memory_order_relaxed);
+  }
+  push_preroll(frame);
+  skipped_.fetch_add(frame_samples_, std::memory_order_relaxed);
+}
+
+void VoiceGate::stop_gating() {
+  // What the gate held back belongs to audio before the switch; left in
+  // place it would be replayed in front of unrelated audio once gating is
+  // back on.
+  preroll_head_ = 0;
+  preroll_fill_ = 0;
+  hang_left_ = 0;
+  open_ = false;
+  open_flag_.store(false, std::memory_order_relaxed);
+  if (pause_frames_ == 0 && !pending_.empty()) {
+    // Nothing frames the audio in bypass, so the partial frame goes now.
+    sink_(pending_);
+    pending_.clear();
+  }
+}
+
+void VoiceGate::emit() {
+  if (!out_.empty()) {
+    sink_(out_);
+    out_.clear();
+  }
+}
+
+void VoiceGate::push_preroll(const short *frame) {
+  const size_t cap = preroll_.size();
+  if (cap == 0) {
+    return;
+  }
+  for (size_t k = 0; k < frame_samples_; ++k) {
+    preroll_[preroll_head_] = frame[k];
+    preroll_head_ = (preroll_head_ + 1) % cap;
+  }
+  preroll_fill_ = std::min(cap, preroll_fill_ + frame_samples_);
+}
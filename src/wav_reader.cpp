@@ -0,0 +1,188 @@
+#include "wav_reader.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+constexpr uint16_t kFormatPcm = 1;
+constexpr uint16_t kFormatFloat = 3;
+constexpr uint16_t kFormatExtensible = 0xFFFE;
+// Streaming writers leave the data size at 0 or 0xFFFFFFFF until they finish.
+constexpr uint32_t kUnknownSize = 0xFFFFFFFF;
+
+uint16_t le16(const uint8_t *p) {
+  return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t le32(const uint8_t *p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+}  // namespace
+
+bool WavReader::open(const std::filesystem::path &path, std::string &error) {
+  close();
+  stream_.open(path, std::ios::binary);
+  if (!stream_) {
+    error = "cannot open " + path.string();
+    return false;
+  }
+  std::error_code ec;
+  const uint64_t file_size = std::filesystem::file_size(path, ec);
+
+  uint8_t header[12];
+  if (!stream_.read(reinterpret_cast<char *>(header), sizeof(header)) || std::memcmp(header, "RIFF", 4) != 0 ||
+      std::memcmp(header + 8, "WAVE", 4) != 0) {
+    error = "not a RIFF/WAVE file";
+    return false;
+  }
+
+  bool have_format = false;
+  uint16_t format = 0;
+  uint16_t bits = 0;
+  uint64_t offset = sizeof(header);
+  while (true) {
+    uint8_t chunk[8];
+    if (!stream_.read(reinterpret_cast<char *>(chunk), sizeof(chunk))) {
+      error = "no data chunk";
+      return false;
+    }
+    offset += sizeof(chunk);
+    const uint32_t size = le32(chunk + 4);
+
+    if (std::memcmp(chunk, "fmt ", 4) == 0) {
+      uint8_t fmt[40] = {};
+      const size_t want = std::min<size_t>(size, sizeof(fmt));
+      if (size < 16 || !stream_.read(reinterpret_cast<char *>(fmt), static_cast<std::streamsize>(want))) {
+        error = "truncated fmt chunk";
+        return false;
+      }
+      format = le16(fmt);
+      channels_ = le16(fmt + 2);
+      rate_ = le32(fmt + 4);
+      block_align_ = le16(fmt + 12);
+      bits = le16(fmt + 14);
+      // The sub-format GUID starts with the plain format tag.
+      if (format == kFormatExtensible && size >= 26) {
+        format = le16(fmt + 24);
+      }
+      have_format = true;
+    } else if (std::memcmp(chunk, "data", 4) == 0) {
+      if (!have_format) {
+        error = "data chunk before fmt chunk";
+        return false;
+      }
+      data_offset_ = offset;
+      uint64_t data_size = size;
+      if (file_size > offset && (size == kUnknownSize || size == 0 || data_size > file_size - offset)) {
+        data_size = file_size - offset;
+      }
+      frames_ = block_align_ ? data_size / block_align_ : 0;
+      break;
+    }
+    // Chunks are word aligned.
+    offset += size + (size & 1);
+    stream_.seekg(static_cast<std::streamoff>(offset));
+  }
+
+  if (format == kFormatPcm && bits == 8) {
+    encoding_ = Encoding::Pcm8;
+  } else if (format == kFormatPcm && bits == 16) {
+    encoding_ = Encoding::Pcm16;
+  } else if (format == kFormatPcm && bits == 24) {
+    encoding_ = Encoding::Pcm24;
+  } else if (format == kFormatPcm && bits == 32) {
+    encoding_ = Encoding::Pcm32;
+  } else if (format == kFormatFloat && bits == 32) {
+    encoding_ = Encoding::Float32;
+  } else {
+    error = "unsupported sample format (tag " + std::to_string(format) + ", " + std::to_string(bits) + " bits)";
+    return false;
+  }
+  if (channels_ == 0 || rate_ == 0 || block_align_ != channels_ * (bits / 8)) {
+    error = "inconsistent fmt chunk";
+    return false;
+  }
+  position_ = 0;
+  return true;
+}
+
+void WavReader::close() {
+  if (stream_.is_open()) {
+    stream_.close();
+  }
+  stream_.clear();
+  frames_ = 0;
+  position_ = 0;
+}
+
+bool WavReader::seek(uint64_t frame) {
+  if (!stream_.is_open() || frame > frames_) {
+    return false;
+  }
+  stream_.clear();
+  stream_.seekg(static_cast<std::streamoff>(data_offset_ + frame * block_align_));
+  position_ = frame;
+  return static_cast<bool>(stream_);
+}
+
+size_t WavReader::read_raw(size_t max_frames) {
+  const size_t frames = static_cast<size_t>(std::min<uint64_t>(max_frames, frames_ - position_));
+  if (frames == 0 || !stream_.is_open()) {
+    return 0;
+  }
+  raw_.resize(frames * block_align_);
+  stream_.read(reinterpret_cast<char *>(raw_.data()), static_cast<std::streamsize>(raw_.size()));
+  // A file still being written may be shorter than its header says.
+  const size_t got = static_cast<size_t>(stream_.gcount()) / block_align_;
+  position_ += got;
+  if (got < frames) {
+    frames_ = position_;
+  }
+  return got;
+}
+
+size_t WavReader::read(float *interleaved, size_t max_frames) {
+  const size_t frames = read_raw(max_frames);
+  const size_t samples = frames * channels_;
+  const uint8_t *p = raw_.data();
+  switch (encoding_) {
+  case Encoding::Pcm8:
+    for (size_t i = 0; i < samples; ++i) {
+      interleaved[i] = (static_cast<float>(p[i]) - 128.0f) * (1.0f / 128.0f);
+    }
+    break;
+  case Encoding::Pcm16:
+    for (size_t i = 0; i < samples; ++i) {
+      interleaved[i] = static_cast<float>(static_cast<int16_t>(le16(p + i * 2))) * (1.0f / 32768.0f);
+    }
+    break;
+  case Encoding::Pcm24:
+    for (size_t i = 0; i < samples; ++i) {
+      const uint8_t *s = p + i * 3;
+      // Place the 24 bits at the top of an int32 so the sign carries.
+      const int32_t v = static_cast<int32_t>((static_cast<uint32_t>(s[0]) << 8) | (static_cast<uint32_t>(s[1]) << 16) |
+                                             (static_cast<uint32_t>(s[2]) << 24));
+      interleaved[i] = static_cast<float>(v) * (1.0f / 2147483648.0f);
+    }
+    break;
+  case Encoding::Pcm32:
+    for (size_t i = 0; i < samples; ++i) {
+      interleaved[i] = static_cast<float>(static_cast<int32_t>(le32(p + i * 4))) * (1.0f / 2147483648.0f);
+    }
+    break;
+  case Encoding::Float32:
+    std::memcpy(interleaved, p, samples * sizeof(float));
+    break;
+  }
+  return frames;
+}
+
+size_t WavReader::read_pcm16(short *interleaved, size_t max_frames) {
+  if (encoding_ != Encoding::Pcm16) {
+    return 0;
+  }
+  const size_t frames = read_raw(max_frames);
+  std::memcpy(interleaved, raw_.data(), frames * channels_ * sizeof(short));
+  return frames;
+}
@@ -0,0 +1,72 @@
+// Stands in for april-asr so AprilAsrEngine can be driven without a model.
+// Sessions decode synchronously inside aas_feed_pcm16(): loud audio yields a
+// short partial, and a quarter second of quiet after it yields a silence
+// report. Neither allocates, so tests see only what the engine itself does.
+
+#include <cstdlib>
+
+#include "april_api.h"
+
+struct AprilASRModel_i {
+  size_t sample_rate;
+};
+
+struct AprilASRSession_i {
+  AprilConfig config;
+  size_t quiet = 0;
+  bool speaking = false;
+};
+
+namespace {
+constexpr size_t kRate = 16000;
+constexpr short kSpeechLevel = 1000;
+const AprilToken kWord = {" word", 0.0f, APRIL_TOKEN_FLAG_WORD_BOUNDARY_BIT, 0, nullptr};
+}  // namespace
+
+void aam_api_init(int) {}
+
+AprilASRModel aam_create_model(const char *) {
+  return new AprilASRModel_i{kRate};
+}
+
+size_t aam_get_sample_rate(AprilASRModel model) {
+  return model->sample_rate;
+}
+
+void aam_free(AprilASRModel model) {
+  delete model;
+}
+
+AprilASRSession aas_create_session(AprilASRModel, AprilConfig config) {
+  return new AprilASRSession_i{config};
+}
+
+void aas_feed_pcm16(AprilASRSession session, short *pcm16, size_t count) {
+  bool loud = false;
+  for (size_t i = 0; i < count; ++i) {
+    loud = loud || std::abs(pcm16[i]) > kSpeechLevel;
+  }
+  if (loud) {
+    session->quiet = 0;
+    session->speaking = true;
+    session->config.handler(session->config.userdata, APRIL_RESULT_RECOGNITION_PARTIAL, 1, &kWord);
+    return;
+  }
+  session->quiet += count;
+  if (session->speaking && session->quiet >= kRate / 4) {
+    session->speaking = false;
+    session->config.handler(session->config.userdata, APRIL_RESULT_SILENCE, 0, nullptr);
+  }
+}
+
+void aas_flush(AprilASRSession session) {
+  session->speaking = false;
+}
+
+float aas_realtime_get_speedup(AprilASRSession) {
+  return 1.0f;
+}
+
+void aas_free(AprilASRSession session) {
+  delete session;
+}
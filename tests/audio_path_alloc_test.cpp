@@ -0,0 +1,210 @@
+// Once warmed up, the per-packet audio path must not touch the heap: what a
+// capture backend runs per packet (downmix, resample, feeder write) and what
+// the feeder thread runs per chunk (voice gate into the engine, its chunking
+// and overlap buffer, and the decoder's partial and silence callbacks). An
+// hour of capture is pushed through unpaced, so growth that only shows over
+// a long run is caught too. Counted by replacing the global allocation
+// functions; april-asr is replaced by april_stub.cpp.
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "april_asr.h"
+#include "april_model.h"
+#include "audio_feeder.h"
+#include "check.h"
+#include "downmix.h"
+#include "resampler.h"
+#include "voice_gate.h"
+
+namespace {
+std::atomic<bool> counting{false};
+std::atomic<uint64_t> allocations{0};
+
+void *allocate(size_t size) {
+  if (counting.load(std::memory_order_relaxed)) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (void *p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+}  // namespace
+
+void *operator new(size_t size) {
+  return allocate(size);
+}
+void *operator new[](size_t size) {
+  return allocate(size);
+}
+void operator delete(void *p) noexcept {
+  std::free(p);
+}
+void operator delete[](void *p) noexcept {
+  std::free(p);
+}
+void operator delete(void *p, size_t) noexcept {
+  std::free(p);
+}
+void operator delete[](void *p, size_t) noexcept {
+  std::free(p);
+}
+
+namespace {
+constexpr size_t kCaptureRate = 48000;
+constexpr size_t kModelRate = 16000;
+constexpr size_t kChannels = 2;
+
+// Stereo 48 kHz packets of varying size, as WASAPI and PipeWire deliver them:
+// speech-like bursts with pauses so the voice gate opens and closes.
+std::vector<float> packet(size_t index, size_t frames) {
+  std::vector<float> out(frames * kChannels);
+  const bool speech = (index / 40) % 2 == 0;
+  for (size_t n = 0; n < frames; ++n) {
+    const double t = static_cast<double>(index * 480 + n) / kCaptureRate;
+    const float v = speech ? 0.3f * static_cast<float>(std::sin(2.0 * 3.14159 * 220.0 * t)) : 0.0001f;
+    out[n * kChannels] = v;
+    out[n * kChannels + 1] = v;
+  }
+  return out;
+}
+}  // namespace
+
+int main(int, char **argv) {
+  Downmixer downmix;
+  Resampler resampler;
+  CHECK(downmix.configure(kChannels));
+  CHECK(resampler.configure(kCaptureRate, kModelRate));
+  // The largest packet below; backends reserve for their buffer size.
+  constexpr size_t kMaxFrames = 1024;
+  resampler.reserve(kMaxFrames);
+  std::vector<float> mono(kMaxFrames);
+  std::vector<float> resampled;
+  resampled.reserve(kMaxFrames);
+
+  // The stub backend never reads the model file; any existing path will do.
+  AprilAsrEngine engine;
+  CHECK(engine.set_model(AprilModel::load(argv[0])));
+  CHECK(engine.sample_rate() == kModelRate);
+  engine.set_chunk_ms(50);
+  CHECK(engine.start());
+
+  VoiceGate gate;
+  VoiceGate::Config gate_config;
+  gate_config.enabled = true;
+  gate_config.pause_ms = 300;
+  std::atomic<uint64_t> engine_samples{0};
+  std::atomic<uint64_t> pauses{0};
+  std::atomic<uint64_t> silence_hints{0};
+  gate.configure(
+      kModelRate, gate_config,
+      [&](std::span<const short> samples) {
+        engine_samples.fetch_add(samples.size());
+        engine.push_pcm16(samples);
+      },
+      [&]() {
+        pauses.fetch_add(1);
+        engine.flush();
+      });
+
+  // Drains without dropping: the writer below waits for room instead of
+  // keeping realtime.
+  AudioFeeder feeder;
+  AudioFeeder::Options options;
+  options.poll_ms = 1;
+  options.drop_late = false;
+  CHECK(feeder.start(
+      kModelRate,
+      [&](std::span<const short> samples) {
+        gate.process(samples);
+        if (engine.take_silence_hint()) {
+          silence_hints.fetch_add(1);
+          engine.flush();
+        }
+      },
+      options));
+
+  // Built up front: the packets themselves are the test's, not the path's.
+  // Cycled for the whole run; 400 is a whole number of speech/pause turns.
+  const size_t sizes[] = {480, 441, 1024, 256, 960, 513};
+  std::vector<std::vector<float>> packets;
+  for (size_t i = 0; i < 400; ++i) {
+    packets.push_back(packet(i, sizes[i % std::size(sizes)]));
+  }
+  std::vector<short> pcm16(kMaxFrames);
+
+  uint64_t captured_frames = 0;
+  uint64_t written_samples = 0;
+  auto run = [&](size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      const auto &in = packets[i % packets.size()];
+      const size_t frames = in.size() / kChannels;
+      downmix.process(in.data(), frames, mono.data());
+      resampler.process(std::span<const float>(mono.data(), frames), resampled);
+      while (feeder.free_space() < resampled.size()) {
+        std::this_thread::yield();
+      }
+      if (i % 2 == 0) {
+        feeder.write(resampled);
+      } else {
+        for (size_t n = 0; n < resampled.size(); ++n) {
+          pcm16[n] = static_cast<short>(resampled[n] * 32767.0f);
+        }
+        feeder.write_pcm16(std::span<const short>(pcm16.data(), resampled.size()));
+      }
+      captured_frames += frames;
+      written_samples += resampled.size();
+    }
+  };
+  auto drain = [&]() {
+    while (feeder.stats().fill > 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  };
+
+  // Warm up: first calls may size buffers.
+  run(packets.size());
+  drain();
+
+  counting = true;
+  const auto started = std::chrono::steady_clock::now();
+  size_t hour_packets = 0;
+  for (uint64_t frames = 0; frames < 3600 * kCaptureRate; ++hour_packets) {
+    frames += packets[hour_packets % packets.size()].size() / kChannels;
+  }
+  run(hour_packets);
+  drain();
+  counting = false;
+  const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+  feeder.stop();
+  engine.stop();
+  const auto gate_stats = gate.stats();
+  const auto feeder_stats = feeder.stats();
+  std::printf("%.0f s captured in %.1f s: %llu samples to the engine, %llu skipped, %llu pauses, %llu silence "
+              "hints, %llu allocations\n",
+              static_cast<double>(captured_frames) / kCaptureRate, elapsed,
+              static_cast<unsigned long long>(engine_samples.load()),
+              static_cast<unsigned long long>(gate_stats.skipped_samples),
+              static_cast<unsigned long long>(pauses.load()), static_cast<unsigned long long>(silence_hints.load()),
+              static_cast<unsigned long long>(allocations.load()));
+  CHECK(captured_frames >= 3600 * kCaptureRate);
+  CHECK(feeder_stats.overflow_samples == 0 && feeder_stats.late_samples == 0);
+  CHECK(gate_stats.processed_samples == written_samples);
+  CHECK(engine_samples.load() > 0);
+  CHECK(gate_stats.skipped_samples > 0);
+  CHECK(pauses.load() > 0);
+  CHECK(silence_hints.load() > 0);
+  CHECK_MSG(allocations.load() == 0, "%llu heap allocations in steady state",
+            static_cast<unsigned long long>(allocations.load()));
+  std::printf("ok\n");
+  return 0;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// Stops the test at the first failed check, printing where and why.
+#define CHECK(cond)                                                                  \
+  do {                                                                               \
+    if (!(cond)) {                                                                   \
+      std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      std::exit(1);                                                                  \
+    }                                                                                \
+  } while (0)
+
+// Same, with a printf-style explanation.
+#define CHECK_MSG(cond, ...)                                                         \
+  do {                                                                               \
+    if (!(cond)) {                                                                   \
+      std::fprintf(stderr, "%s:%d: check failed: %s: ", __FILE__, __LINE__, #cond); \
+      std::fprintf(stderr, __VA_ARGS__);                                             \
+      std::fputc('\n', stderr);                                                      \
+      std::exit(1);                                                                  \
+    }                                                                                \
+  } while (0)
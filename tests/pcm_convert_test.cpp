@@ -0,0 +1,122 @@
+// The dispatched kernels must match the scalar reference bit for bit, on any
+// input and length, whichever kernel this CPU selects.
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "check.h"
+#include "pcm_convert.h"
+
+namespace {
+constexpr size_t kMaxLength = 67;
+
+void check_convert(const std::vector<float> &in) {
+  std::vector<short> expected(in.size());
+  std::vector<short> actual(in.size());
+  // Every length and start offset, so each kernel's tail path runs.
+  for (size_t offset = 0; offset < 4 && offset < in.size(); ++offset) {
+    for (size_t count = 0; offset + count <= in.size() && count <= kMaxLength; ++count) {
+      float_to_pcm16_scalar(in.data() + offset, expected.data(), count);
+      float_to_pcm16(in.data() + offset, actual.data(), count);
+      for (size_t i = 0; i < count; ++i) {
+        CHECK_MSG(expected[i] == actual[i], "input %a (bits %08x): scalar %d, %s %d", static_cast<double>(in[offset + i]),
+                  std::bit_cast<uint32_t>(in[offset + i]), expected[i], pcm_convert_kernel_name(), actual[i]);
+      }
+    }
+  }
+}
+
+void check_mix(const std::vector<short> &a, const std::vector<short> &b, float gain_a, float gain_b) {
+  std::vector<short> expected(a.size());
+  std::vector<short> actual(a.size());
+  mix_pcm16_scalar(a.data(), gain_a, b.data(), gain_b, expected.data(), a.size());
+  mix_pcm16(a.data(), gain_a, b.data(), gain_b, actual.data(), a.size());
+  for (size_t i = 0; i < a.size(); ++i) {
+    CHECK_MSG(expected[i] == actual[i], "%d * %g + %d * %g: scalar %d, %s %d", a[i], static_cast<double>(gain_a), b[i],
+              static_cast<double>(gain_b), expected[i], pcm_convert_kernel_name(), actual[i]);
+  }
+  // In place, as the feeder mixes into its own chunk.
+  std::vector<short> aliased = a;
+  mix_pcm16(aliased.data(), gain_a, b.data(), gain_b, aliased.data(), a.size());
+  CHECK(aliased == expected);
+}
+}  // namespace
+
+int main() {
+  std::printf("kernel: %s\n", pcm_convert_kernel_name());
+  std::mt19937 rng(12345);
+
+  // Edge cases: range limits, signed zeros, infinities, NaNs, denormals.
+  constexpr float kInf = std::numeric_limits<float>::infinity();
+  std::vector<float> special = {0.0f,
+                                -0.0f,
+                                1.0f,
+                                -1.0f,
+                                std::nextafter(1.0f, 2.0f),
+                                std::nextafter(-1.0f, -2.0f),
+                                std::nextafter(1.0f, 0.0f),
+                                1e30f,
+                                -1e30f,
+                                kInf,
+                                -kInf,
+                                std::numeric_limits<float>::quiet_NaN(),
+                                -std::numeric_limits<float>::quiet_NaN(),
+                                std::numeric_limits<float>::signaling_NaN(),
+                                std::numeric_limits<float>::denorm_min(),
+                                -std::numeric_limits<float>::denorm_min(),
+                                std::numeric_limits<float>::min()};
+  // Inputs whose scaled value lands on or next to a rounding tie.
+  for (int k = -32768; k <= 32767; k += 97) {
+    const float tie = (static_cast<float>(k) + 0.5f) / 32767.0f;
+    special.push_back(tie);
+    special.push_back(std::nextafter(tie, 2.0f));
+    special.push_back(std::nextafter(tie, -2.0f));
+  }
+  std::shuffle(special.begin(), special.end(), rng);
+  for (size_t start = 0; start < special.size(); start += kMaxLength) {
+    check_convert(std::vector<float>(special.begin() + static_cast<std::ptrdiff_t>(start),
+                                     special.begin() + static_cast<std::ptrdiff_t>(std::min(special.size(), start + kMaxLength))));
+  }
+
+  // Random audio-range samples and random bit patterns.
+  std::uniform_real_distribution<float> audio(-1.2f, 1.2f);
+  std::uniform_int_distribution<uint32_t> bits;
+  for (int round = 0; round < 200; ++round) {
+    std::vector<float> in(kMaxLength + 3);
+    for (float &x : in) {
+      x = round % 2 == 0 ? audio(rng) : std::bit_cast<float>(bits(rng));
+    }
+    check_convert(in);
+  }
+
+  // Mixing: ordinary and extreme gains, saturation both ways, every length.
+  std::uniform_int_distribution<int> sample(-32768, 32767);
+  std::uniform_real_distribution<float> gain(0.0f, 2.0f);
+  const float fixed_gains[][2] = {{1.0f, 1.0f}, {0.5f, 0.5f}, {0.0f, 1.0f}, {1.0f, 0.0f}, {2.0f, 2.0f}, {0.7f, 1.3f}};
+  for (int round = 0; round < 400; ++round) {
+    const size_t length = static_cast<size_t>(round) % (kMaxLength + 1);
+    std::vector<short> a(length);
+    std::vector<short> b(length);
+    for (size_t i = 0; i < length; ++i) {
+      a[i] = static_cast<short>(sample(rng));
+      b[i] = static_cast<short>(sample(rng));
+    }
+    if (round % 10 == 0) {
+      std::fill(a.begin(), a.end(), round % 20 == 0 ? 32767 : -32768);
+    }
+    if (round < static_cast<int>(std::size(fixed_gains))) {
+      check_mix(a, b, fixed_gains[round][0], fixed_gains[round][1]);
+    } else {
+      check_mix(a, b, gain(rng), gain(rng));
+    }
+  }
+
+  std::printf("ok\n");
+  return 0;
+}